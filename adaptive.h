@@ -0,0 +1,276 @@
+/**
+ * Adaptive filter: picks one of the offline filters per call, from the
+ * window width and the monotone run lengths of the input.
+ *
+ * The monotone wedge filters (lemire, bitmap) do less work the longer the
+ * input rises or falls without turning, while van Herk/Gil-Werman and
+ * Gil-Kimmel do the same work on any input and have no branches to
+ * mispredict on noise. Before filtering, adaptivemaxmin estimates the mean
+ * run length from a few evenly spaced stretches of the input (at most 4096
+ * comparisons, none for short inputs, which are treated as noise), then
+ * looks the engine up in a table indexed by width class (1, 2, 3-4, 5-8,
+ * ...) and run length class (below 2, 2-3, 4-7, ...).
+ *
+ * The default table encodes crossovers measured on x86-64 with AVX2: the
+ * vectorized van Herk filter wins from width 5 up for the types it
+ * supports on the host; Gil-Kimmel for the others from width 9 up, except
+ * that the bitmap filter wins on floating-point runs of 64 and more while
+ * the window fits in one bitmap word (64 samples); below width 9, the
+ * bitmap filter wins on runs of 16 and more and scalar van Herk on noise.
+ * The bitmap filter costs O(width / 64) per sample, so it is never picked
+ * for wider windows. calibrate() measures every cell on the host instead,
+ * and save() and load() keep the result in a file.
+ */
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "generators.h"
+#include "harness.h"
+#include "runningmaxmin.h"
+#include "vanherksimd.h"
+
+enum class maxminengine { vanherk, vanherksimd, gilkimmel, bitmap, lemire };
+
+inline const char * enginename(maxminengine engine) {
+    static const char * const names[] = {"vanherk", "vanherksimd",
+                                         "gilkimmel", "bitmap", "lemire"};
+    return names[static_cast<int>(engine)];
+}
+
+/**
+ * Mean length of the monotone runs of array[0, n) under comp, estimated on
+ * up to 16 stretches of 256 samples; 0 if n is too short to bother.
+ */
+template <typename T, typename Compare>
+double meanrunlength(const T * array, size_t n, Compare comp) {
+    const size_t stretch = 256;
+    const size_t stretches = std::min<size_t>(16, n / (8 * stretch));
+    if (stretches == 0)
+        return 0;
+    size_t pairs = 0, turns = 0;
+    for (size_t s = 0; s < stretches; ++s) {
+        const T * p = array + (n - stretch) * s / stretches;
+        bool rising = comp(p[0], p[1]);
+        for (size_t k = 2; k < stretch; ++k) {
+            const bool r = comp(p[k - 1], p[k]);
+            turns += r != rising;
+            rising = r;
+        }
+        pairs += stretch - 1;
+    }
+    return static_cast<double>(pairs) / (turns + stretches);
+}
+
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class adaptivemaxmin : public minmaxfilter<T> {
+public:
+    static const int widthclasses = 14; // the last one is for 4097 and up
+    static const int runclasses = 10;   // the last one is for 512 and up
+    // the bitmap filter scans width / 64 words per sample: past one word,
+    // it loses to Gil-Kimmel on any input
+    static const int bitmapwidthclasses = 7; // widths up to 64
+    typedef std::vector<maxminengine> enginetable; // [width][runs] classes
+
+    // whether vanherksimd has a vector path for T on this host
+    static bool vectorized() {
+        return vanHerkGilWermanmaxminsimd<T, Compare, Sides>::vectorizedon(
+            hostisa());
+    }
+
+    adaptivemaxmin(std::vector<T> & array, int width,
+                   Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filter(array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> & ws,
+                       Compare comp = Compare()) {
+        run(choose(array, n, width, comp), array, n, width, maxvalues,
+            minvalues, ws, comp);
+    }
+
+    static maxminengine choose(const T * array, size_t n, uint width,
+                               Compare comp = Compare()) {
+        const double runs = meanrunlength(array, n, comp);
+        return table()[widthclass(width) * runclasses + runclass(runs)];
+    }
+
+    // runs the given engine, whatever the table says
+    static void run(maxminengine engine, const T * array, size_t n,
+                    uint width, T * maxvalues, T * minvalues,
+                    filterworkspace<T> & ws, Compare comp = Compare()) {
+        switch (engine) {
+        case maxminengine::vanherk:
+            vanHerkGilWermanmaxmin<T, Compare, Sides>::filter(
+                array, n, width, maxvalues, minvalues, ws, comp);
+            break;
+        case maxminengine::vanherksimd:
+            vanHerkGilWermanmaxminsimd<T, Compare, Sides>::filter(
+                array, n, width, maxvalues, minvalues, ws, comp);
+            break;
+        case maxminengine::gilkimmel:
+            GilKimmel<T, Compare, Sides>::filter(array, n, width, maxvalues,
+                                                 minvalues, ws, comp);
+            break;
+        case maxminengine::bitmap:
+            lemirebitmapmaxmin<T, Compare, Sides>::filter(
+                array, n, width, maxvalues, minvalues, ws, comp);
+            break;
+        case maxminengine::lemire:
+            lemiremaxmin<T, Compare, Sides>::filter(array, n, width,
+                                                    maxvalues, minvalues, ws,
+                                                    comp);
+            break;
+        }
+    }
+
+    static int widthclass(uint width) {
+        return width <= 1 ? 0
+                          : std::min(widthclasses - 1, highestbit(width - 1) + 1);
+    }
+    static int runclass(double runs) {
+        return runs < 2 ? 0
+                        : std::min(runclasses - 1,
+                                   highestbit(static_cast<uint64_t>(runs)));
+    }
+
+    // the table in use for this filter type (not thread-safe to change)
+    static enginetable & table() {
+        static enginetable t = defaults();
+        return t;
+    }
+
+    static enginetable defaults() {
+        enginetable t(widthclasses * runclasses);
+        const bool floating = std::is_floating_point<T>::value;
+        for (int w = 0; w < widthclasses; ++w)
+            for (int r = 0; r < runclasses; ++r) {
+                maxminengine & e = t[w * runclasses + r];
+                if (vectorized() && w >= 3)
+                    e = maxminengine::vanherksimd;
+                else if (w >= 4)
+                    e = floating && r >= 6 && w < bitmapwidthclasses
+                            ? maxminengine::bitmap
+                            : maxminengine::gilkimmel;
+                else
+                    e = r >= 4 ? maxminengine::bitmap : maxminengine::vanherk;
+            }
+        return t;
+    }
+
+    /**
+     * Times every engine on every cell of the table (a width of the class
+     * over monotone runs of the class, of n samples at least 32 times the
+     * width), keeps the fastest in table() and returns the table. Takes a
+     * few seconds.
+     */
+    static const enginetable & calibrate(size_t n = size_t(1) << 16,
+                                         uint repetitions = 3) {
+        std::vector<maxminengine> engines = {
+            maxminengine::vanherk, maxminengine::gilkimmel,
+            maxminengine::bitmap, maxminengine::lemire};
+        if (vectorized())
+            engines.push_back(maxminengine::vanherksimd);
+        xoshiro256 rng;
+        enginetable t(widthclasses * runclasses);
+        for (int r = 0; r < runclasses; ++r) {
+            signalspec spec;
+            parsesignal(r == 0 ? std::string("white")
+                               : "runs:" + std::to_string(3 << (r - 1)),
+                        spec);
+            const size_t size =
+                std::max(n, size_t(32) << (widthclasses - 1));
+            const std::vector<T> data = convert<T>(generate(spec, size, rng));
+            for (int w = 0; w < widthclasses; ++w) {
+                const uint width = 1u << w;
+                const size_t length = std::max(n, size_t(32) * width);
+                std::vector<T> maxvalues(length - width + 1);
+                std::vector<T> minvalues(length - width + 1);
+                filterworkspace<T> ws;
+                double best = 0;
+                for (maxminengine e : engines) {
+                    const double ns =
+                        measure(enginename(e), spec.name, "", width, length,
+                                repetitions,
+                                [&] {
+                                    run(e, data.data(), length, width,
+                                        maxvalues.data(), minvalues.data(),
+                                        ws);
+                                })
+                            .nsperelement()
+                            .median;
+                    if (e == engines.front() || ns < best) {
+                        best = ns;
+                        t[w * runclasses + r] = e;
+                    }
+                }
+            }
+        }
+        return table() = t;
+    }
+
+    // writes table() to path; false on failure
+    static bool save(const std::string & path) {
+        std::ofstream out(path);
+        out << "adaptivemaxmin " << widthclasses << " " << runclasses << "\n";
+        for (int w = 0; w < widthclasses; ++w) {
+            for (int r = 0; r < runclasses; ++r)
+                out << (r == 0 ? "" : " ")
+                    << enginename(table()[w * runclasses + r]);
+            out << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+    // replaces table() with the one saved at path; false (and no change)
+    // if it cannot be read
+    static bool load(const std::string & path) {
+        std::ifstream in(path);
+        std::string magic, name;
+        int widths = 0, runs = 0;
+        if (!(in >> magic >> widths >> runs) || magic != "adaptivemaxmin" ||
+            widths != widthclasses || runs != runclasses)
+            return false;
+        enginetable t(widthclasses * runclasses);
+        for (maxminengine & e : t) {
+            if (!(in >> name))
+                return false;
+            int k = 0;
+            while (k <= static_cast<int>(maxminengine::lemire) &&
+                   name != enginename(static_cast<maxminengine>(k)))
+                ++k;
+            if (k > static_cast<int>(maxminengine::lemire))
+                return false;
+            e = static_cast<maxminengine>(k);
+        }
+        table() = t;
+        return true;
+    }
+
+    std::vector<T> & getmaxvalues() {
+        return maxvalues;
+    }
+    std::vector<T> & getminvalues() {
+        return minvalues;
+    }
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
+};
+
+#endif
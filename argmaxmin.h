@@ -0,0 +1,98 @@
+/**
+ * Positions of the running maximum and minimum (argmax/argmin), from any of
+ * the offline filters.
+ *
+ * lemiremaxmin and vanHerkGilWermanmaxmin track positions themselves (their
+ * filter() overload with argmax and argmin), and argfilter calls them
+ * directly. Any other filter runs over (value, position) samples under an
+ * order that breaks ties between equal values by position, so every window
+ * has a single extremum and the filter itself needs no change. As the
+ * preferred sample must be the greatest on the max side but the least on the
+ * min side, the two sides are then computed by separate one-sided passes.
+ */
+
+#ifndef ARGMAXMIN_H
+#define ARGMAXMIN_H
+
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "runningmaxmin.h"
+
+// whether Filter::filter writes positions itself
+template <template <typename, typename, minmaxsides, typename...> class Filter>
+struct argnative : std::false_type {};
+template <>
+struct argnative<lemiremaxmin> : std::true_type {};
+template <>
+struct argnative<vanHerkGilWermanmaxmin> : std::true_type {};
+
+// orders samples by value, then ranks equal values so that the one picked
+// by Ties is the max (ismax) or the min of the window
+template <typename T, typename Compare, argties Ties, bool ismax>
+struct argcompare {
+    Compare comp;
+    bool operator()(const Sample<T> & a, const Sample<T> & b) const {
+        if (comp(a.value, b.value))
+            return true;
+        if (comp(b.value, a.value))
+            return false;
+        const bool earlierwins = Ties != argties::last;
+        return earlierwins == ismax ? a.time > b.time : a.time < b.time;
+    }
+};
+
+template <template <typename, typename, minmaxsides, typename...> class Filter,
+          argties Ties, typename T, typename Compare>
+void argfilter(const T * array, size_t n, uint width, uint * argmax,
+               uint * argmin, Compare comp, std::true_type) {
+    Filter<T, Compare, minmaxsides::both>::template filter<Ties>(
+        array, n, width, nullptr, nullptr, argmax, argmin, comp);
+}
+
+template <template <typename, typename, minmaxsides, typename...> class Filter,
+          argties Ties, typename T, typename Compare>
+void argfilter(const T * array, size_t n, uint width, uint * argmax,
+               uint * argmin, Compare comp, std::false_type) {
+    std::vector<Sample<T>> samples(n);
+    for (size_t i = 0; i < n; ++i) {
+        samples[i].value = array[i];
+        samples[i].time = static_cast<uint>(i);
+    }
+    std::vector<Sample<T>> extrema(n - width + 1);
+    if (argmax != nullptr) {
+        typedef argcompare<T, Compare, Ties, true> order;
+        Filter<Sample<T>, order, minmaxsides::maxonly>::filter(
+            samples.data(), n, width, extrema.data(), nullptr, order{comp});
+        for (size_t k = 0; k < extrema.size(); ++k)
+            argmax[k] = extrema[k].time;
+    }
+    if (argmin != nullptr) {
+        typedef argcompare<T, Compare, Ties, false> order;
+        Filter<Sample<T>, order, minmaxsides::minonly>::filter(
+            samples.data(), n, width, nullptr, extrema.data(), order{comp});
+        for (size_t k = 0; k < extrema.size(); ++k)
+            argmin[k] = extrema[k].time;
+    }
+}
+
+/**
+ * Writes the positions of the max and the min of each window of
+ * array[0, n) into argmax and argmin[0, n - width + 1); either may be null.
+ * Filter is any filter class template, e.g.,
+ *   argfilter<lemiremaxmin>(array, n, width, argmax, argmin);
+ *   argfilter<vanHerkGilWermanmaxmin, argties::last>(array, n, width,
+ *                                                    argmax, nullptr);
+ * With argties::any, the first occurrence is reported.
+ */
+template <template <typename, typename, minmaxsides, typename...> class Filter,
+          argties Ties = argties::first, typename T,
+          typename Compare = std::less<T>>
+void argfilter(const T * array, size_t n, uint width, uint * argmax,
+               uint * argmin, Compare comp = Compare()) {
+    argfilter<Filter, Ties>(array, n, width, argmax, argmin, comp,
+                            argnative<Filter>());
+}
+
+#endif
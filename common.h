@@ -2,7 +2,44 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 typedef unsigned int uint;
 typedef double floattype;
 
+// the time-stamp counter on x86, 0 elsewhere
+inline uint64_t cyclecounter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Which side(s) a filter computes, chosen at compile time through its last
+ * template parameter. With maxonly (minonly) the min (max) side does no
+ * work at all: its output vector stays empty and the static filter
+ * functions accept a null pointer for it.
+ */
+enum class minmaxsides { both, maxonly, minonly };
+
+constexpr bool hasmax(minmaxsides sides) {
+    return sides != minmaxsides::minonly;
+}
+constexpr bool hasmin(minmaxsides sides) {
+    return sides != minmaxsides::maxonly;
+}
+
+/**
+ * Which position argmax/argmin report when several samples of a window tie
+ * for the extremum: the earliest, the latest, or whichever is cheapest to
+ * track (any, for filters that only need the values).
+ */
+enum class argties { any, first, last };
+
 #endif
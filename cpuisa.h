@@ -0,0 +1,71 @@
+/**
+ * Instruction sets chosen at run time.
+ *
+ * The headers build for the baseline of the target (SSE2 on x86-64) and
+ * carry AVX2 and AVX-512 variants of their kernels, so that one binary runs
+ * on any x86-64 host and uses what it has:
+ *
+ * - the filter entry points of runningmaxmin.h are marked
+ *   MAXMIN_MULTIVERSION: GCC compiles each once per instruction set
+ *   (target_clones) and the loader picks a clone through cpuid when the
+ *   program starts;
+ * - vanherksimd.h compiles its AVX2 and AVX-512 paths under target pragmas
+ *   and picks one from hostisa(), which reads cpuid once.
+ *
+ * Other compilers get only the vector paths enabled on their command line
+ * (-mavx2, -mavx512f).
+ */
+
+#ifndef CPUISA_H
+#define CPUISA_H
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) &&     \
+    !defined(__clang__)
+#define MAXMIN_TARGET_PRAGMAS 1
+#define MAXMIN_MULTIVERSION                                                   \
+    __attribute__((target_clones("default", "avx2", "avx512f")))
+#else
+#define MAXMIN_MULTIVERSION
+#endif
+
+#if defined(MAXMIN_TARGET_PRAGMAS) || defined(__AVX2__)
+#define MAXMIN_AVX2 1
+#endif
+#if defined(MAXMIN_TARGET_PRAGMAS) || defined(__AVX512F__)
+#define MAXMIN_AVX512 1
+#endif
+
+enum class cpuisa { sse2, avx2, avx512 };
+
+inline const char * isaname(cpuisa isa) {
+    return isa == cpuisa::avx512 ? "avx512" : isa == cpuisa::avx2 ? "avx2"
+#if defined(__x86_64__) || defined(__i386__)
+                                                                   : "sse2";
+#else
+                                                                   : "baseline";
+#endif
+}
+
+// the widest instruction set of the host that this build has kernels for
+inline cpuisa detectisa() {
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+#if defined(MAXMIN_AVX512)
+    if (__builtin_cpu_supports("avx512f"))
+        return cpuisa::avx512;
+#endif
+#if defined(MAXMIN_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return cpuisa::avx2;
+#endif
+#endif
+    return cpuisa::sse2;
+}
+
+inline cpuisa hostisa() {
+    static const cpuisa isa = detectisa();
+    return isa;
+}
+
+#endif
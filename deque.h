@@ -2,6 +2,15 @@
 #ifndef DEQUE_H
 #define DEQUE_H
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+
 #include "common.h"
 
 // nextPowerOfTwo returns a power of two that is larger or equal than x.
@@ -13,62 +22,378 @@ inline uint nextPowerOfTwo(uint x) {
     return result;
 }
 
+// the index is a sample counter, or any ordered key such as a timestamp
+template <typename T = floattype, typename I = uint>
 struct intfloatnode {
-    uint index;
-    floattype value;
+    I index;
+    T value;
 };
 
+template <typename T = floattype, typename I = uint>
 struct intfloatqueue {
-    intfloatnode * nodes;
+    intfloatnode<T, I> * nodes;
     uint head;
     uint tail;
     uint mask;
 };
 
-inline uint count(intfloatqueue * q) {
+template <typename T, typename I>
+inline uint count(intfloatqueue<T, I> * q) {
     return (q->tail - q->head) & q->mask;
 }
 
-inline void init(intfloatqueue * q, uint size) {
+template <typename T, typename I>
+inline void init(intfloatqueue<T, I> * q, uint size) {
     size = nextPowerOfTwo(size + 1);
-    q->nodes =
-        reinterpret_cast<intfloatnode *>(malloc(sizeof(intfloatnode) * size));
+    q->nodes = reinterpret_cast<intfloatnode<T, I> *>(
+        malloc(sizeof(intfloatnode<T, I>) * size));
     q->head = 0;
     q->tail = 0;
     q->mask = size - 1;
 }
 
-inline void free(intfloatqueue * q) {
+// number of nodes a queue initialized with init(q, size) holds
+inline uint nodecount(uint size) {
+    return nextPowerOfTwo(size + 1);
+}
+
+// initializes q over caller-provided storage of nodecount(size) nodes;
+// such a queue must not be passed to free
+template <typename T, typename I>
+inline void init(intfloatqueue<T, I> * q, intfloatnode<T, I> * nodes,
+                 uint size) {
+    q->nodes = nodes;
+    q->head = 0;
+    q->tail = 0;
+    q->mask = nodecount(size) - 1;
+}
+
+template <typename T, typename I>
+inline void free(intfloatqueue<T, I> * q) {
     free(q->nodes);
 }
 
-inline uint headindex(intfloatqueue * q) {
+// moves the content of a malloc'ed q into room for at least size nodes
+template <typename T, typename I>
+inline void grow(intfloatqueue<T, I> * q, uint size) {
+    intfloatqueue<T, I> bigger;
+    init(&bigger, size);
+    for (uint i = q->head; i != q->tail; i = (i + 1) & q->mask)
+        bigger.nodes[bigger.tail++] = q->nodes[i];
+    free(q);
+    *q = bigger;
+}
+
+template <typename T, typename I>
+inline I headindex(intfloatqueue<T, I> * q) {
     return q->nodes[q->head].index;
 }
 
-inline void push(intfloatqueue * q, uint index, floattype value) {
+template <typename T, typename I>
+inline void push(intfloatqueue<T, I> * q, I index, T value) {
     q->nodes[q->tail].index = index;
     q->nodes[q->tail].value = value;
     q->tail = (q->tail + 1) & q->mask;
 }
 
-inline floattype tailvalue(intfloatqueue * q) {
+template <typename T, typename I>
+inline T tailvalue(intfloatqueue<T, I> * q) {
     return q->nodes[(q->tail - 1) & q->mask].value;
 }
 
-inline floattype headvalue(intfloatqueue * q) {
+template <typename T, typename I>
+inline T headvalue(intfloatqueue<T, I> * q) {
     return q->nodes[q->head].value;
 }
-inline void prunehead(intfloatqueue * q) {
+template <typename T, typename I>
+inline void prunehead(intfloatqueue<T, I> * q) {
     q->head = (q->head + 1) & q->mask;
 }
 
-inline void prunetail(intfloatqueue * q) {
+template <typename T, typename I>
+inline void prunetail(intfloatqueue<T, I> * q) {
     q->tail = (q->tail - 1) & q->mask;
 }
 
-inline int nonempty(intfloatqueue * q) {
+template <typename T, typename I>
+inline int nonempty(intfloatqueue<T, I> * q) {
     return static_cast<int>(q->tail != q->head);
 }
 
+// number of samples between the head and sample number index; counters are
+// compared modulo 2^32, so the sample counter may wrap
+template <typename T>
+inline uint headage(intfloatqueue<T, uint> * q, uint index) {
+    return index - headindex(q);
+}
+
+// largest age headage can report, hence the largest window width
+template <typename T, typename I>
+inline uint maxage(intfloatqueue<T, I> *) {
+    return std::numeric_limits<uint>::max();
+}
+
+/**
+ * Compact variant of intfloatqueue for streaming filters over windows of at
+ * most maxage() samples: values and indices are held in separate arrays
+ * (no padding between them) and each index is kept as its low bits only,
+ * a stamp of type S. Ages are taken modulo 2^(8 * sizeof(S)), which is exact
+ * as long as no queued sample is older than the window. With S = uint16_t, a
+ * double entry takes 10 bytes rather than 16 and a float entry 6 rather
+ * than 8. The same functions as for intfloatqueue apply, except that
+ * headindex returns the stamp and that there is no grow.
+ */
+template <typename T = floattype, typename S = uint16_t>
+struct compactqueue {
+    T * values;
+    S * stamps; // in the same allocation, after the values
+    uint head;
+    uint tail;
+    uint mask;
+};
+
+template <typename T, typename S>
+inline uint count(compactqueue<T, S> * q) {
+    return (q->tail - q->head) & q->mask;
+}
+
+template <typename T, typename S>
+inline void init(compactqueue<T, S> * q, uint size) {
+    size = nextPowerOfTwo(size + 1);
+    q->values =
+        reinterpret_cast<T *>(malloc((sizeof(T) + sizeof(S)) * size));
+    q->stamps = reinterpret_cast<S *>(q->values + size);
+    q->head = 0;
+    q->tail = 0;
+    q->mask = size - 1;
+}
+
+template <typename T, typename S>
+inline void free(compactqueue<T, S> * q) {
+    free(q->values);
+}
+
+template <typename T, typename S>
+inline S headindex(compactqueue<T, S> * q) {
+    return q->stamps[q->head];
+}
+
+template <typename T, typename S>
+inline uint headage(compactqueue<T, S> * q, uint index) {
+    return static_cast<S>(static_cast<S>(index) - headindex(q));
+}
+
+template <typename T, typename S>
+inline uint maxage(compactqueue<T, S> *) {
+    return std::numeric_limits<S>::max();
+}
+
+template <typename T, typename S>
+inline void push(compactqueue<T, S> * q, uint index, T value) {
+    q->stamps[q->tail] = static_cast<S>(index);
+    q->values[q->tail] = value;
+    q->tail = (q->tail + 1) & q->mask;
+}
+
+template <typename T, typename S>
+inline T tailvalue(compactqueue<T, S> * q) {
+    return q->values[(q->tail - 1) & q->mask];
+}
+
+template <typename T, typename S>
+inline T headvalue(compactqueue<T, S> * q) {
+    return q->values[q->head];
+}
+
+template <typename T, typename S>
+inline void prunehead(compactqueue<T, S> * q) {
+    q->head = (q->head + 1) & q->mask;
+}
+
+template <typename T, typename S>
+inline void prunetail(compactqueue<T, S> * q) {
+    q->tail = (q->tail - 1) & q->mask;
+}
+
+template <typename T, typename S>
+inline int nonempty(compactqueue<T, S> * q) {
+    return static_cast<int>(q->tail != q->head);
+}
+
+/**
+ * Fixed-capacity double-ended queue over a power-of-two ring, for the
+ * monotonic wedges of the offline filters. Unlike std::deque, front() and
+ * back() are one masked index away and the elements sit in one 64-byte
+ * aligned block, allocated once by reserve(). A wedge over windows of width
+ * samples never holds more than width + 1 entries; pushing past capacity()
+ * is an error.
+ *
+ * Positions are kept as running counters and masked on access, so that
+ * size() is tail - head and iterators are plain positions (random access,
+ * as mono_wedge's binary search needs).
+ */
+template <typename V>
+class ringqueue {
+public:
+    static_assert(std::is_trivially_copyable<V>::value,
+                  "ringqueue holds plain values");
+
+    class iterator {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef V value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef V * pointer;
+        typedef V & reference;
+
+        iterator() : q(nullptr), pos(0) {}
+        iterator(ringqueue * queue, size_t position) : q(queue), pos(position) {}
+        V & operator*() const {
+            return q->data[pos & q->mask];
+        }
+        V * operator->() const {
+            return &**this;
+        }
+        V & operator[](difference_type k) const {
+            return *(*this + k);
+        }
+        iterator & operator++() {
+            ++pos;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++pos;
+            return old;
+        }
+        iterator & operator--() {
+            --pos;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator old = *this;
+            --pos;
+            return old;
+        }
+        iterator & operator+=(difference_type k) {
+            pos += k;
+            return *this;
+        }
+        iterator & operator-=(difference_type k) {
+            pos -= k;
+            return *this;
+        }
+        iterator operator+(difference_type k) const {
+            return iterator(q, pos + k);
+        }
+        iterator operator-(difference_type k) const {
+            return iterator(q, pos - k);
+        }
+        difference_type operator-(const iterator & o) const {
+            return static_cast<difference_type>(pos - o.pos);
+        }
+        bool operator==(const iterator & o) const {
+            return pos == o.pos;
+        }
+        bool operator!=(const iterator & o) const {
+            return pos != o.pos;
+        }
+        bool operator<(const iterator & o) const {
+            return *this - o < 0;
+        }
+        bool operator>(const iterator & o) const {
+            return o < *this;
+        }
+        bool operator<=(const iterator & o) const {
+            return !(o < *this);
+        }
+        bool operator>=(const iterator & o) const {
+            return !(*this < o);
+        }
+
+    private:
+        ringqueue * q;
+        size_t pos;
+        friend class ringqueue;
+    };
+
+    ringqueue() : raw(nullptr), data(nullptr), mask(0), head(0), tail(0) {}
+    explicit ringqueue(size_t capacity) : ringqueue() {
+        reserve(capacity);
+    }
+    ~ringqueue() {
+        std::free(raw);
+    }
+    ringqueue(const ringqueue &) = delete;
+    ringqueue & operator=(const ringqueue &) = delete;
+
+    // makes room for capacity entries, discarding the content
+    void reserve(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        std::free(raw);
+        raw = std::malloc(size * sizeof(V) + 63);
+        if (raw == nullptr)
+            throw std::bad_alloc();
+        data = reinterpret_cast<V *>(
+            (reinterpret_cast<uintptr_t>(raw) + 63) & ~uintptr_t(63));
+        mask = size - 1;
+        head = tail = 0;
+    }
+    size_t capacity() const {
+        return data == nullptr ? 0 : mask + 1;
+    }
+
+    bool empty() const {
+        return head == tail;
+    }
+    size_t size() const {
+        return tail - head;
+    }
+    V & front() {
+        return data[head & mask];
+    }
+    V & back() {
+        return data[(tail - 1) & mask];
+    }
+    V & operator[](size_t k) {
+        return data[(head + k) & mask];
+    }
+    void push_back(const V & value) {
+        assert(size() < capacity());
+        data[tail++ & mask] = value;
+    }
+    void pop_back() {
+        --tail;
+    }
+    void pop_front() {
+        ++head;
+    }
+    void clear() {
+        head = tail = 0;
+    }
+
+    iterator begin() {
+        return iterator(this, head);
+    }
+    iterator end() {
+        return iterator(this, tail);
+    }
+    // only suffixes can go: last must be end()
+    iterator erase(iterator first, iterator last) {
+        assert(last == end());
+        (void)last;
+        tail = first.pos;
+        return end();
+    }
+
+private:
+    void * raw;
+    V * data;
+    size_t mask;
+    size_t head;
+    size_t tail;
+};
+
 #endif
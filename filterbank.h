@@ -0,0 +1,188 @@
+/**
+ * Streaming maximum-minimum filter bank: the running max and min of one
+ * stream over several window widths at once.
+ *
+ * The monotonic wedge of the widest window holds the answer for every
+ * narrower one: the max over the last w samples is the first wedge entry
+ * less than w samples old. So the bank keeps a single wedge per side, sized
+ * for the widest window, and update() does the work of a single
+ * lemiremaxmintruestreaming, whatever the number of widths.
+ *
+ * The entry of each width is found when max(k) or min(k) asks for it, from
+ * a cursor left by the previous query of that width:
+ *
+ *  - if the entry under the cursor is still in the wedge, so are all the
+ *    entries before it, and they are still too old: the search gallops
+ *    forward from the cursor, in O(log d) steps to move d entries, which is
+ *    O(1) when the width is read after every sample;
+ *  - if it was pruned since, the search is a binary search from the head of
+ *    the wedge, in O(log widest) steps.
+ */
+
+#ifndef FILTERBANK_H
+#define FILTERBANK_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "common.h"
+#include "deque.h"
+
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class lemiremaxminbank {
+public:
+    // widths may come in any order; max(k) and min(k) refer to widths[k]
+    explicit lemiremaxminbank(const std::vector<uint> & widths,
+                              Compare c = Compare())
+        : ww(widths), up(), lo(), n(0), comp(c) {
+        const uint widest =
+            widths.empty() ? 1 : *std::max_element(widths.begin(), widths.end());
+        if (hasmax(Sides))
+            up.init(widest, widths.size());
+        if (hasmin(Sides))
+            lo.init(widest, widths.size());
+    }
+
+    void update(T value) {
+        if (n != 0) {
+            // the previous sample is the tail of both wedges
+            const T previous = hasmax(Sides) ? up.tailvalue() : lo.tailvalue();
+            if (comp(previous, value)) {
+                if (hasmax(Sides)) {
+                    up.prunetail();
+                    while (!up.empty() && !comp(value, up.tailvalue()))
+                        up.prunetail();
+                }
+            } else if (hasmin(Sides)) {
+                lo.prunetail();
+                while (!lo.empty() && !comp(lo.tailvalue(), value))
+                    lo.prunetail();
+            }
+        }
+        if (hasmax(Sides))
+            up.append(n, value);
+        if (hasmin(Sides))
+            lo.append(n, value);
+        n++;
+    }
+
+    /**
+     * Same as calling update(in[i]) and then storing max(k) and min(k) into
+     * out_max and out_min[i * widths() + k], for i in [0, count).
+     */
+    void update_batch(const T * in, size_t count, T * out_max, T * out_min) {
+        const size_t nw = widths();
+        for (size_t i = 0; i < count; ++i) {
+            update(in[i]);
+            for (size_t k = 0; k < nw; ++k) {
+                if (hasmax(Sides))
+                    out_max[i * nw + k] = max(k);
+                if (hasmin(Sides))
+                    out_min[i * nw + k] = min(k);
+            }
+        }
+    }
+
+    size_t widths() const {
+        return ww.size();
+    }
+    uint width(size_t k) const {
+        return ww[k];
+    }
+    // extremum over the last widths[k] samples (fewer at the start)
+    T max(size_t k) const {
+        return up.find(k, n - 1, ww[k]).value;
+    }
+    T min(size_t k) const {
+        return lo.find(k, n - 1, ww[k]).value;
+    }
+    // position of that extremum in the stream
+    uint argmax(size_t k) const {
+        return up.find(k, n - 1, ww[k]).index;
+    }
+    uint argmin(size_t k) const {
+        return lo.find(k, n - 1, ww[k]).index;
+    }
+
+private:
+    // ring of wedge entries, with the last answer of each width as a cursor
+    // (its position and sample number); positions are running counters,
+    // masked on access
+    struct wedge {
+        std::vector<intfloatnode<T>> nodes;
+        mutable std::vector<uint> cursors;
+        mutable std::vector<uint> cursorindices;
+        uint head;
+        uint tail;
+        uint mask;
+        uint widest;
+
+        void init(uint width, size_t count) {
+            nodes.resize(nodecount(width));
+            cursors.assign(count, 0);
+            cursorindices.assign(count, 0);
+            head = tail = 0;
+            mask = static_cast<uint>(nodes.size()) - 1;
+            widest = width;
+        }
+        bool empty() const {
+            return head == tail;
+        }
+        T tailvalue() const {
+            return nodes[(tail - 1) & mask].value;
+        }
+        void prunetail() {
+            --tail;
+        }
+        // pushes sample number index, then drops the head if it is too old
+        void append(uint index, T value) {
+            nodes[tail & mask].index = index;
+            nodes[tail & mask].value = value;
+            tail++;
+            if (index - nodes[head & mask].index == widest)
+                ++head;
+        }
+        // the oldest entry less than width samples older than sample newest,
+        // starting from cursor k and leaving it there
+        const intfloatnode<T> & find(size_t k, uint newest, uint width) const {
+            uint from = head;
+            const uint c = cursors[k];
+            if (c - head < tail - head &&
+                nodes[c & mask].index == cursorindices[k])
+                from = c;
+            const auto inside = [&](uint offset) {
+                return newest - nodes[(from + offset) & mask].index < width;
+            };
+            // the newest entry is always inside: gallop, then bisect
+            const uint last = tail - 1 - from;
+            uint out = 0, in = 0;
+            if (!inside(0)) {
+                in = 1;
+                while (in < last && !inside(in)) {
+                    out = in;
+                    in = std::min(2 * in, last);
+                }
+                while (in - out > 1) {
+                    const uint middle = out + (in - out) / 2;
+                    if (inside(middle))
+                        in = middle;
+                    else
+                        out = middle;
+                }
+            }
+            cursors[k] = from + in;
+            cursorindices[k] = nodes[(from + in) & mask].index;
+            return nodes[(from + in) & mask];
+        }
+    };
+
+    std::vector<uint> ww; // as given
+    wedge up;
+    wedge lo;
+    uint n;
+    Compare comp;
+};
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * Optional instrumentation of the streaming filter, chosen at compile time
+ * through the Stats template parameter of lemiremaxmintruestreaming.
+ *
+ * With nostats (the default) the hooks are empty inline functions and the
+ * counts the filter would hand them are dead code, so the filter compiles
+ * to what it was without them. With filterstats<>, every update records:
+ *
+ *  - the queue entries left in up and lo, as a histogram per queue and a
+ *    maximum;
+ *  - the entries pruned from the tails (pops) and the heads (evictions);
+ *  - the value comparisons: the paper bounds them by 3 per element, plus
+ *    one on non-increasing samples with argties::first or last;
+ *  - the time-stamp counter ticks of the update, two counter reads
+ *    included (about 20 to 40 cycles on x86; always 0 elsewhere), unless
+ *    the filter uses filterstats<false>.
+ *
+ * Histograms have power-of-two buckets: bucket 0 counts zeros and bucket
+ * k > 0 counts values in [2^(k-1), 2^k). snapshot() copies the counts out,
+ * and writejson() and writeprometheus() export a copy. The counts are plain
+ * integers: take the snapshot on the thread that feeds the filter (between
+ * blocks, say) and publish the copy.
+ */
+
+#ifndef FILTERSTATS_H
+#define FILTERSTATS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "common.h"
+
+// does nothing, at no cost
+struct nostats {
+    uint64_t start() const {
+        return 0;
+    }
+    void record(uint64_t, uint, uint, uint, uint, uint) {}
+};
+
+struct filtercounts {
+    static const int buckets = 34; // enough for any 32-bit count
+
+    uint64_t updates = 0;
+    uint64_t comparisons = 0;
+    uint64_t pops = 0;
+    uint64_t evictions = 0;
+    uint64_t ticks = 0;
+    uint maxdepth[2] = {0, 0}; // up, lo
+    uint64_t depthsum[2] = {0, 0};
+    uint64_t depth[2][buckets] = {};
+    uint64_t popsperupdate[buckets] = {};
+    uint64_t comparisonsperupdate[buckets] = {};
+    uint64_t ticksperupdate[buckets] = {};
+
+    // the bucket of value x
+    static int bucket(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return x == 0 ? 0 : std::min(buckets - 1, 64 - __builtin_clzll(x));
+#else
+        int b = 0;
+        for (; x != 0 && b < buckets - 1; x >>= 1)
+            ++b;
+        return b;
+#endif
+    }
+    // the largest value counted in bucket b (the last one is unbounded)
+    static uint64_t bucketbound(int b) {
+        return (uint64_t(1) << b) - 1;
+    }
+
+    double comparisonsperelement() const {
+        return updates == 0 ? 0 : static_cast<double>(comparisons) / updates;
+    }
+
+    // adds the counts of another filter, for totals over many filters
+    filtercounts & operator+=(const filtercounts & other) {
+        updates += other.updates;
+        comparisons += other.comparisons;
+        pops += other.pops;
+        evictions += other.evictions;
+        ticks += other.ticks;
+        for (int q = 0; q < 2; ++q) {
+            maxdepth[q] = std::max(maxdepth[q], other.maxdepth[q]);
+            depthsum[q] += other.depthsum[q];
+            for (int b = 0; b < buckets; ++b)
+                depth[q][b] += other.depth[q][b];
+        }
+        for (int b = 0; b < buckets; ++b) {
+            popsperupdate[b] += other.popsperupdate[b];
+            comparisonsperupdate[b] += other.comparisonsperupdate[b];
+            ticksperupdate[b] += other.ticksperupdate[b];
+        }
+        return *this;
+    }
+};
+
+// with Timed false, the ticks are not read and stay at 0
+template <bool Timed = true>
+class filterstats {
+public:
+    uint64_t start() const {
+        return Timed ? cyclecounter() : 0;
+    }
+    // one update, begun at start() and leaving depthup and depthlo entries
+    void record(uint64_t start, uint depthup, uint depthlo, uint pops,
+                uint evictions, uint comparisons) {
+        const uint64_t ticks = Timed ? cyclecounter() - start : 0;
+        c.updates++;
+        c.comparisons += comparisons;
+        c.pops += pops;
+        c.evictions += evictions;
+        c.ticks += ticks;
+        c.maxdepth[0] = std::max(c.maxdepth[0], depthup);
+        c.maxdepth[1] = std::max(c.maxdepth[1], depthlo);
+        c.depthsum[0] += depthup;
+        c.depthsum[1] += depthlo;
+        c.depth[0][filtercounts::bucket(depthup)]++;
+        c.depth[1][filtercounts::bucket(depthlo)]++;
+        c.popsperupdate[filtercounts::bucket(pops)]++;
+        c.comparisonsperupdate[filtercounts::bucket(comparisons)]++;
+        c.ticksperupdate[filtercounts::bucket(ticks)]++;
+    }
+
+    filtercounts snapshot() const {
+        return c;
+    }
+    void reset() {
+        c = filtercounts();
+    }
+
+private:
+    filtercounts c;
+};
+
+// the bucket counts up to the last nonzero one, as a JSON array
+inline void writestatsbuckets(std::ostream & out, const uint64_t * counts) {
+    int last = filtercounts::buckets - 1;
+    while (last > 0 && counts[last] == 0)
+        --last;
+    out << "[";
+    for (int b = 0; b <= last; ++b)
+        out << (b == 0 ? "" : ", ") << counts[b];
+    out << "]";
+}
+
+/**
+ * One JSON object; histograms are arrays of bucket counts, without the
+ * trailing empty buckets.
+ */
+inline void writejson(std::ostream & out, const filtercounts & c) {
+    out << "{\"updates\": " << c.updates << ", \"comparisons\": "
+        << c.comparisons << ", \"comparisons_per_element\": "
+        << c.comparisonsperelement() << ", \"pops\": " << c.pops
+        << ", \"evictions\": " << c.evictions << ", \"ticks\": " << c.ticks
+        << ", \"max_depth\": {\"up\": " << c.maxdepth[0]
+        << ", \"lo\": " << c.maxdepth[1] << "}, \"depth\": {\"up\": ";
+    writestatsbuckets(out, c.depth[0]);
+    out << ", \"lo\": ";
+    writestatsbuckets(out, c.depth[1]);
+    out << "}, \"pops_per_update\": ";
+    writestatsbuckets(out, c.popsperupdate);
+    out << ", \"comparisons_per_update\": ";
+    writestatsbuckets(out, c.comparisonsperupdate);
+    out << ", \"ticks_per_update\": ";
+    writestatsbuckets(out, c.ticksperupdate);
+    out << "}" << std::endl;
+}
+
+// the samples of one Prometheus histogram, cumulative up to +Inf
+inline void writestatshistogram(std::ostream & out, const std::string & name,
+                                const uint64_t * counts, uint64_t total,
+                                uint64_t sum, const std::string & labels) {
+    const std::string open = labels.empty() ? "{" : "{" + labels + ",";
+    const std::string only = labels.empty() ? "" : "{" + labels + "}";
+    uint64_t cumulative = 0;
+    for (int b = 0; b < filtercounts::buckets - 1; ++b) {
+        cumulative += counts[b];
+        out << name << "_bucket" << open << "le=\""
+            << filtercounts::bucketbound(b) << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket" << open << "le=\"+Inf\"} " << total << "\n";
+    out << name << "_sum" << only << " " << sum << "\n";
+    out << name << "_count" << only << " " << total << "\n";
+}
+
+inline void writestatsheader(std::ostream & out, const std::string & name,
+                             const char * type, const char * help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+/**
+ * The Prometheus text format: counters and cumulative histograms named
+ * after prefix, each sample carrying labels (such as filter="price"),
+ * which may be empty. The queue depths are one histogram with a queue
+ * label, "up" or "lo".
+ */
+inline void writeprometheus(std::ostream & out, const filtercounts & c,
+                            const std::string & prefix = "maxmin",
+                            const std::string & labels = "") {
+    const std::string only = labels.empty() ? "" : "{" + labels + "}";
+    const std::string comma = labels.empty() ? "" : labels + ",";
+    const struct {
+        const char * name;
+        const char * help;
+        uint64_t value;
+    } counters[] = {
+        {"_updates_total", "Samples fed to the filter.", c.updates},
+        {"_comparisons_total", "Value comparisons.", c.comparisons},
+        {"_pops_total", "Entries pruned from the queue tails.", c.pops},
+        {"_evictions_total", "Entries that left the window.", c.evictions}};
+    for (const auto & k : counters) {
+        writestatsheader(out, prefix + k.name, "counter", k.help);
+        out << prefix << k.name << only << " " << k.value << "\n";
+    }
+    writestatsheader(out, prefix + "_queue_depth", "histogram",
+                     "Queue entries after each update.");
+    writestatshistogram(out, prefix + "_queue_depth", c.depth[0], c.updates,
+                        c.depthsum[0], comma + "queue=\"up\"");
+    writestatshistogram(out, prefix + "_queue_depth", c.depth[1], c.updates,
+                        c.depthsum[1], comma + "queue=\"lo\"");
+    writestatsheader(out, prefix + "_pops_per_update", "histogram",
+                     "Entries pruned from the queue tails per update.");
+    writestatshistogram(out, prefix + "_pops_per_update", c.popsperupdate,
+                        c.updates, c.pops, labels);
+    writestatsheader(out, prefix + "_comparisons_per_update", "histogram",
+                     "Value comparisons per update.");
+    writestatshistogram(out, prefix + "_comparisons_per_update",
+                        c.comparisonsperupdate, c.updates, c.comparisons,
+                        labels);
+    writestatsheader(out, prefix + "_update_ticks", "histogram",
+                     "Time-stamp counter ticks per update.");
+    writestatshistogram(out, prefix + "_update_ticks", c.ticksperupdate,
+                        c.updates, c.ticks, labels);
+    out.flush();
+}
+
+#endif
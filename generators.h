@@ -0,0 +1,250 @@
+/**
+ * Synthetic test signals for the benchmarks, from a seeded xoshiro256**
+ * generator so that every run is reproducible and independent of rand().
+ *
+ * A signal is named by a spec "name" or "name:parameter":
+ *
+ *   white           uniform noise in [-0.5, 0.5)
+ *   walk            random walk of white steps
+ *   sine:P          sine wave of period P samples (500)
+ *   runs:L          piecewise monotone: alternately rising and falling runs
+ *                   of geometric length, mean L samples (32)
+ *   sawtooth:P      rising ramps of P samples, each followed by a drop (100)
+ *   steps:L         constant levels held for geometric lengths, mean L (100)
+ *   spikes:p        low noise with spikes of either sign, probability p
+ *                   per sample (0.01)
+ *   cauchy          heavy-tailed (Cauchy) noise
+ *   quantized:Q     white noise rounded to Q levels, many ties (16)
+ *   wedgefill       strictly falling ramp: the max wedge of the monotone
+ *                   wedge filters stays full, one eviction per sample
+ *   wedgeflush:L    falling runs of L samples, each ended by a sample above
+ *                   all of them that pops the whole max wedge at once (100)
+ *
+ * White noise is the worst case for the branches of the wedge filters;
+ * wedgefill and wedgeflush are the worst cases for their memory and per
+ * update latency. The van Herk/Gil-Werman filters do the same work on any
+ * signal.
+ */
+
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "common.h"
+
+class xoshiro256 {
+public:
+    explicit xoshiro256(uint64_t seed = 1) {
+        reseed(seed);
+    }
+    // fills the state from seed through splitmix64, as its authors advise
+    void reseed(uint64_t seed) {
+        for (uint64_t & word : s) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+    uint64_t operator()() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    // uniform in [0, 1)
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * (1.0 / (1ULL << 53));
+    }
+    // uniform in [0, bound)
+    uint64_t below(uint64_t bound) {
+        return static_cast<uint64_t>(uniform() * bound);
+    }
+    // at least 1, geometric with the given mean
+    size_t geometric(double mean) {
+        if (mean <= 1)
+            return 1;
+        const double u = 1 - uniform(); // in (0, 1]
+        return 1 + static_cast<size_t>(std::log(u) / std::log(1 - 1 / mean));
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+    uint64_t s[4];
+};
+
+enum class signalshape {
+    white,
+    walk,
+    sine,
+    runs,
+    sawtooth,
+    steps,
+    spikes,
+    cauchy,
+    quantized,
+    wedgefill,
+    wedgeflush
+};
+
+struct signalspec {
+    signalshape shape;
+    double parameter;
+    std::string name; // as given, for reports
+};
+
+/**
+ * Parses "name" or "name:parameter" into spec, with the default parameter
+ * of the shape when it is omitted; false if the name is unknown.
+ */
+inline bool parsesignal(const std::string & text, signalspec & spec) {
+    struct known {
+        const char * name;
+        signalshape shape;
+        double parameter;
+    };
+    static const known shapes[] = {
+        {"white", signalshape::white, 0},
+        {"walk", signalshape::walk, 0},
+        {"sine", signalshape::sine, 500},
+        {"runs", signalshape::runs, 32},
+        {"sawtooth", signalshape::sawtooth, 100},
+        {"steps", signalshape::steps, 100},
+        {"spikes", signalshape::spikes, 0.01},
+        {"cauchy", signalshape::cauchy, 0},
+        {"quantized", signalshape::quantized, 16},
+        {"wedgefill", signalshape::wedgefill, 0},
+        {"wedgeflush", signalshape::wedgeflush, 100}};
+    const size_t colon = text.find(':');
+    const std::string name = text.substr(0, colon);
+    for (const known & k : shapes)
+        if (name == k.name) {
+            spec.shape = k.shape;
+            spec.parameter = k.parameter;
+            spec.name = text;
+            if (colon != std::string::npos) {
+                char * end;
+                spec.parameter = std::strtod(text.c_str() + colon + 1, &end);
+                if (*end != '\0' || !(spec.parameter > 0))
+                    return false;
+            }
+            return true;
+        }
+    return false;
+}
+
+// n samples of the signal, drawing from rng
+inline std::vector<floattype> generate(const signalspec & spec, size_t n,
+                                       xoshiro256 & rng) {
+    std::vector<floattype> data(n);
+    const double p = spec.parameter;
+    switch (spec.shape) {
+    case signalshape::white:
+        for (size_t k = 0; k < n; ++k)
+            data[k] = rng.uniform() - 0.5;
+        break;
+    case signalshape::walk:
+        for (size_t k = 0; k < n; ++k)
+            data[k] = (k == 0 ? 0 : data[k - 1]) + rng.uniform() - 0.5;
+        break;
+    case signalshape::sine:
+        for (size_t k = 0; k < n; ++k)
+            data[k] = std::sin(2 * M_PI * k / p);
+        break;
+    case signalshape::runs: {
+        double value = 0, direction = 1;
+        for (size_t k = 0; k < n;) {
+            for (size_t end = std::min(n, k + rng.geometric(p)); k < end; ++k)
+                data[k] = value += direction * (rng.uniform() + 1e-3);
+            direction = -direction;
+        }
+        break;
+    }
+    case signalshape::sawtooth: {
+        const size_t period = std::max<size_t>(1, static_cast<size_t>(p));
+        for (size_t k = 0; k < n; ++k)
+            data[k] = static_cast<double>(k % period) / period;
+        break;
+    }
+    case signalshape::steps:
+        for (size_t k = 0; k < n;) {
+            const double level = rng.uniform();
+            for (size_t end = std::min(n, k + rng.geometric(p)); k < end; ++k)
+                data[k] = level;
+        }
+        break;
+    case signalshape::spikes:
+        for (size_t k = 0; k < n; ++k) {
+            data[k] = 0.01 * (rng.uniform() - 0.5);
+            if (rng.uniform() < p)
+                data[k] += rng.uniform() < 0.5 ? -1 : 1;
+        }
+        break;
+    case signalshape::cauchy:
+        for (size_t k = 0; k < n; ++k)
+            data[k] = std::tan(M_PI * (rng.uniform() - 0.5));
+        break;
+    case signalshape::quantized: {
+        const double levels = std::max(1.0, std::floor(p));
+        for (size_t k = 0; k < n; ++k)
+            data[k] = std::floor(rng.uniform() * levels) / levels - 0.5;
+        break;
+    }
+    case signalshape::wedgefill:
+        for (size_t k = 0; k < n; ++k)
+            data[k] = -static_cast<double>(k);
+        break;
+    case signalshape::wedgeflush: {
+        const size_t run = static_cast<size_t>(p);
+        for (size_t k = 0; k < n; ++k)
+            data[k] = k % (run + 1) == run
+                          ? static_cast<double>(k)
+                          : -static_cast<double>(k % (run + 1));
+        break;
+    }
+    }
+    return data;
+}
+
+/**
+ * Converts generated data to the benchmarked element type. Integer types get
+ * the data rescaled to a quarter of their range so that the shape of the
+ * signal survives the rounding.
+ */
+template <typename T>
+std::vector<T> convert(const std::vector<floattype> & data) {
+    std::vector<T> out(data.size());
+    if (!std::is_integral<T>::value) {
+        for (size_t k = 0; k < data.size(); ++k)
+            out[k] = static_cast<T>(data[k]);
+        return out;
+    }
+    if (data.empty())
+        return out;
+    const floattype lo = *std::min_element(data.begin(), data.end());
+    const floattype hi = *std::max_element(data.begin(), data.end());
+    const floattype range = std::min<floattype>(
+        std::numeric_limits<T>::max() / 4, 1 << 30);
+    const floattype scale = hi > lo ? 2 * range / (hi - lo) : 0;
+    for (size_t k = 0; k < data.size(); ++k)
+        out[k] = static_cast<T>((data[k] - lo) * scale - range);
+    return out;
+}
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * Benchmark harness: repeated timing of one filter run with a steady clock
+ * and the time-stamp counter, optionally with Linux hardware counters, and
+ * reports in text, CSV or JSON.
+ *
+ * A run is a callable that filters one dataset into buffers allocated
+ * beforehand, so that only the filter itself is timed. measure() runs it
+ * once to warm up, then once per repetition, and keeps every repetition;
+ * the reports give the median, mean and variance of the time and of the
+ * time-stamp counter ticks per element, and the median hardware counts.
+ *
+ * The time-stamp counter ticks at a constant reference rate, not the core
+ * clock, on current x86 processors; it reads 0 elsewhere. The hardware
+ * counters come from perf_event_open and are missing (null in JSON, empty
+ * in CSV) where the kernel or the container does not allow them.
+ */
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "common.h"
+
+const int hardwareevents = 3;
+
+inline const char * eventname(int event) {
+    static const char * const names[hardwareevents] = {
+        "instructions", "branch_misses", "cache_misses"};
+    return names[event];
+}
+
+/**
+ * Hardware counters of the calling thread (user space only), counting
+ * between start() and stop(). Each event is opened on its own, so that the
+ * ones the host supports are counted even if others are not.
+ */
+class perfcounters {
+public:
+    perfcounters() {
+        std::fill(fds, fds + hardwareevents, -1);
+#if defined(__linux__)
+        const uint64_t configs[hardwareevents] = {
+            PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_MISSES};
+        for (int e = 0; e < hardwareevents; ++e) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[e];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[e] = static_cast<int>(
+                ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+    ~perfcounters() {
+#if defined(__linux__)
+        for (int e = 0; e < hardwareevents; ++e)
+            if (fds[e] >= 0)
+                ::close(fds[e]);
+#endif
+    }
+    perfcounters(const perfcounters &) = delete;
+    perfcounters & operator=(const perfcounters &) = delete;
+
+    bool available(int event) const {
+        return fds[event] >= 0;
+    }
+    bool anyavailable() const {
+        return std::any_of(fds, fds + hardwareevents,
+                           [](int fd) { return fd >= 0; });
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (int e = 0; e < hardwareevents; ++e)
+            if (fds[e] >= 0) {
+                ::ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+    void stop() {
+#if defined(__linux__)
+        for (int e = 0; e < hardwareevents; ++e)
+            if (fds[e] >= 0)
+                ::ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+    // count of event since the last start(), or 0 if it is not available
+    uint64_t value(int event) const {
+        uint64_t count = 0;
+#if defined(__linux__)
+        if (fds[event] >= 0 &&
+            ::read(fds[event], &count, sizeof(count)) != sizeof(count))
+            count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fds[hardwareevents];
+};
+
+struct summary {
+    double median;
+    double mean;
+    double variance; // unbiased, 0 with one repetition
+};
+
+inline summary summarize(std::vector<double> values, double scale = 1) {
+    summary s = {0, 0, 0};
+    if (values.empty())
+        return s;
+    for (double & v : values)
+        v *= scale;
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    s.median = n % 2 == 1 ? values[n / 2]
+                          : (values[n / 2 - 1] + values[n / 2]) / 2;
+    for (double v : values)
+        s.mean += v;
+    s.mean /= n;
+    if (n > 1) {
+        for (double v : values)
+            s.variance += (v - s.mean) * (v - s.mean);
+        s.variance /= n - 1;
+    }
+    return s;
+}
+
+// the q-quantiles of values, 0 <= q <= 1, by nearest rank
+inline std::vector<double> quantiles(std::vector<double> values,
+                                     const std::vector<double> & qs) {
+    std::vector<double> result(qs.size(), 0);
+    if (values.empty())
+        return result;
+    std::sort(values.begin(), values.end());
+    for (size_t k = 0; k < qs.size(); ++k)
+        result[k] = values[std::min(
+            values.size() - 1,
+            static_cast<size_t>(std::ceil(qs[k] * values.size())) -
+                (qs[k] > 0))];
+    return result;
+}
+
+// all repetitions of one algorithm over one dataset and width
+struct measurement {
+    std::string algorithm;
+    std::string dataset;
+    std::string type;
+    uint width;
+    size_t elements; // per repetition
+    std::vector<double> nanoseconds;
+    std::vector<double> cycles;
+    // per event, one count per repetition; empty if the event is missing
+    std::vector<double> events[hardwareevents];
+
+    summary nsperelement() const {
+        return summarize(nanoseconds, 1.0 / elements);
+    }
+    summary cyclesperelement() const {
+        return summarize(cycles, 1.0 / elements);
+    }
+    bool hasevent(int event) const {
+        return !events[event].empty();
+    }
+    double eventsperelement(int event) const {
+        return summarize(events[event], 1.0 / elements).median;
+    }
+};
+
+/**
+ * Times run() over repetitions (after one untimed warm-up run); run filters
+ * elements values. counters may be null.
+ */
+template <typename Run>
+measurement measure(const std::string & algorithm, const std::string & dataset,
+                    const std::string & type, uint width, size_t elements,
+                    uint repetitions, Run run,
+                    perfcounters * counters = nullptr) {
+    measurement m;
+    m.algorithm = algorithm;
+    m.dataset = dataset;
+    m.type = type;
+    m.width = width;
+    m.elements = std::max<size_t>(elements, 1);
+    run();
+    for (uint r = 0; r < repetitions; ++r) {
+        if (counters != nullptr)
+            counters->start();
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startcycles = cyclecounter();
+        run();
+        const uint64_t endcycles = cyclecounter();
+        const auto end = std::chrono::steady_clock::now();
+        if (counters != nullptr) {
+            counters->stop();
+            for (int e = 0; e < hardwareevents; ++e)
+                if (counters->available(e))
+                    m.events[e].push_back(
+                        static_cast<double>(counters->value(e)));
+        }
+        m.nanoseconds.push_back(
+            std::chrono::duration<double, std::nano>(end - start).count());
+        m.cycles.push_back(static_cast<double>(endcycles - startcycles));
+    }
+    return m;
+}
+
+// one line per measurement, aligned for reading
+inline void writetext(std::ostream & out,
+                      const std::vector<measurement> & results) {
+    out << std::left << std::setw(16) << "#algorithm" << std::setw(10)
+        << "dataset" << std::right << std::setw(8) << "width" << std::setw(12)
+        << "ns/elem" << std::setw(12) << "ns mean" << std::setw(12)
+        << "ns var" << std::setw(12) << "cycles/elem" << std::setw(12)
+        << "cycles mean" << std::setw(12) << "cycles var";
+    for (int e = 0; e < hardwareevents; ++e)
+        out << std::setw(16) << eventname(e);
+    out << std::endl;
+    for (const measurement & m : results) {
+        const summary ns = m.nsperelement();
+        const summary cycles = m.cyclesperelement();
+        out << std::left << std::setw(16) << m.algorithm << std::setw(10)
+            << m.dataset << std::right << std::setw(8) << m.width
+            << std::setw(12) << ns.median << std::setw(12) << ns.mean
+            << std::setw(12) << ns.variance << std::setw(12) << cycles.median
+            << std::setw(12) << cycles.mean << std::setw(12)
+            << cycles.variance;
+        for (int e = 0; e < hardwareevents; ++e) {
+            out << std::setw(16);
+            if (m.hasevent(e))
+                out << m.eventsperelement(e);
+            else
+                out << "-";
+        }
+        out << std::endl;
+    }
+}
+
+inline void writecsv(std::ostream & out,
+                     const std::vector<measurement> & results) {
+    out << "algorithm,dataset,type,width,elements,repetitions,"
+           "ns_per_element_median,ns_per_element_mean,"
+           "ns_per_element_variance,cycles_per_element_median,"
+           "cycles_per_element_mean,cycles_per_element_variance";
+    for (int e = 0; e < hardwareevents; ++e)
+        out << "," << eventname(e) << "_per_element";
+    out << std::endl;
+    for (const measurement & m : results) {
+        const summary ns = m.nsperelement();
+        const summary cycles = m.cyclesperelement();
+        out << m.algorithm << "," << m.dataset << "," << m.type << ","
+            << m.width << "," << m.elements << "," << m.nanoseconds.size()
+            << "," << ns.median << "," << ns.mean << "," << ns.variance << ","
+            << cycles.median << "," << cycles.mean << "," << cycles.variance;
+        for (int e = 0; e < hardwareevents; ++e) {
+            out << ",";
+            if (m.hasevent(e))
+                out << m.eventsperelement(e);
+        }
+        out << std::endl;
+    }
+}
+
+inline void writejson(std::ostream & out, const summary & s) {
+    out << "{\"median\": " << s.median << ", \"mean\": " << s.mean
+        << ", \"variance\": " << s.variance << "}";
+}
+
+// a JSON array with one object per measurement
+inline void writejson(std::ostream & out,
+                      const std::vector<measurement> & results) {
+    out << "[";
+    for (size_t k = 0; k < results.size(); ++k) {
+        const measurement & m = results[k];
+        out << (k == 0 ? "\n" : ",\n");
+        out << "  {\"algorithm\": \"" << m.algorithm << "\", \"dataset\": \""
+            << m.dataset << "\", \"type\": \"" << m.type
+            << "\", \"width\": " << m.width
+            << ", \"elements\": " << m.elements
+            << ", \"repetitions\": " << m.nanoseconds.size()
+            << ", \"ns_per_element\": ";
+        writejson(out, m.nsperelement());
+        out << ", \"cycles_per_element\": ";
+        writejson(out, m.cyclesperelement());
+        for (int e = 0; e < hardwareevents; ++e) {
+            out << ", \"" << eventname(e) << "_per_element\": ";
+            if (m.hasevent(e))
+                out << m.eventsperelement(e);
+            else
+                out << "null";
+        }
+        out << "}";
+    }
+    out << "\n]" << std::endl;
+}
+
+#endif
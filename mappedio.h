@@ -0,0 +1,143 @@
+/**
+ * Memory-mapped binary input and output, to filter files larger than memory.
+ *
+ * Files hold raw little-endian values (float32, float64, int16, ...) with no
+ * header. The input is mapped read-only and the outputs are created at their
+ * final size and mapped shared, so the filters read and write the page cache
+ * directly. filtermapped walks the file in chunks of outputs, in order; each
+ * chunk reads its outputs' input range, overlapping the previous one by
+ * width - 1 samples as in parallel.h. The mappings are advised sequential,
+ * and the pages behind the current chunk are released as it moves on, so
+ * that the resident set stays around one chunk whatever the file size.
+ *
+ * POSIX only (mmap, madvise); values are used as they are in the file, so
+ * the host must be little-endian.
+ */
+
+#ifndef MAPPEDIO_H
+#define MAPPEDIO_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "parallel.h"
+#include "runningmaxmin.h"
+
+inline bool littleendianhost() {
+    const uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+class mappedfile {
+public:
+    // maps the existing file at path for reading
+    explicit mappedfile(const std::string & path)
+        : fd(::open(path.c_str(), O_RDONLY)), base(nullptr), length(0),
+          released(0) {
+        if (fd < 0)
+            fail("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+            fail("cannot stat " + path);
+        length = static_cast<size_t>(st.st_size);
+        map(PROT_READ, path);
+    }
+    // creates (or truncates) the file at path to bytes and maps it for writing
+    mappedfile(const std::string & path, size_t bytes)
+        : fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)),
+          base(nullptr), length(bytes), released(0) {
+        if (fd < 0)
+            fail("cannot create " + path);
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+            fail("cannot resize " + path);
+        map(PROT_READ | PROT_WRITE, path);
+    }
+    ~mappedfile() {
+        if (base != nullptr)
+            ::munmap(base, length);
+        if (fd >= 0)
+            ::close(fd);
+    }
+    mappedfile(const mappedfile &) = delete;
+    mappedfile & operator=(const mappedfile &) = delete;
+
+    size_t size() const {
+        return length;
+    }
+    template <typename T>
+    T * values() const {
+        return reinterpret_cast<T *>(base);
+    }
+
+    // gives the whole pages before byte offset upto back to the kernel
+    // (written pages stay in the page cache until written back)
+    void release(size_t upto) {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        upto = std::min(upto, length) / page * page;
+        if (upto <= released)
+            return;
+        ::madvise(base + released, upto - released, MADV_DONTNEED);
+        released = upto;
+    }
+
+private:
+    void map(int protection, const std::string & path) {
+        if (length == 0)
+            return;
+        void * p = ::mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            fail("cannot map " + path);
+        base = static_cast<char *>(p);
+        ::madvise(base, length, MADV_SEQUENTIAL);
+    }
+    [[noreturn]] void fail(const std::string & what) {
+        const int error = errno;
+        if (fd >= 0)
+            ::close(fd);
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    int fd;
+    char * base;
+    size_t length;
+    size_t released;
+};
+
+/**
+ * Runs Filter over the values of type T in the mapped input, into the
+ * mapped outputs of (n - width + 1) values each (either may be null, with a
+ * one-sided Filter), chunk outputs at a time.
+ */
+template <typename Filter, typename T>
+void filtermapped(mappedfile & in, mappedfile * maxout, mappedfile * minout,
+                  uint width, size_t chunk = size_t(1) << 20) {
+    const T * const array = in.values<const T>();
+    const size_t n = in.size() / sizeof(T);
+    const size_t outputs = n - width + 1;
+    T * const maxvalues = maxout == nullptr ? nullptr : maxout->values<T>();
+    T * const minvalues = minout == nullptr ? nullptr : minout->values<T>();
+    for (size_t begin = 0; begin < outputs; begin += chunk) {
+        const size_t end = std::min(outputs, begin + chunk);
+        Filter::filter(array + begin, end - begin + width - 1, width,
+                       outputslice(maxvalues, begin),
+                       outputslice(minvalues, begin));
+        in.release(end * sizeof(T));
+        if (maxout != nullptr)
+            maxout->release(end * sizeof(T));
+        if (minout != nullptr)
+            minout->release(end * sizeof(T));
+    }
+}
+
+#endif
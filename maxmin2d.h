@@ -0,0 +1,110 @@
+/**
+ * Two-dimensional running maximum-minimum filter (grayscale dilation and
+ * erosion) over rectangular windows of wx columns by wy rows.
+ *
+ * A rectangular max is separable: it is the max, over wy consecutive rows,
+ * of the wx-wide running max of each row. The row pass runs a 1D filter
+ * (van Herk/Gil-Werman by default) along each row. The column pass does not
+ * transpose: each row of row-maxima is handed, as one vector of columns, to
+ * vanHerkmultilanestreaming with one lane per column, so that every step is
+ * a contiguous loop across the row.
+ *
+ * The image is cut into vertical tiles whose column-pass state (about wy
+ * rows of the tile per side) fits in tilebytes, so that it stays in L2 on
+ * large images. Adjacent tiles overlap by wx - 1 input columns.
+ */
+
+#ifndef MAXMIN2D_H
+#define MAXMIN2D_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "multilane.h"
+#include "runningmaxmin.h"
+
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both,
+          typename RowFilter = vanHerkGilWermanmaxmin<T, Compare, Sides>>
+class maxmin2d : public minmaxfilter<T> {
+public:
+    static const size_t defaulttilebytes = 1 << 18;
+
+    // image holds rows of cols values, with no padding
+    maxmin2d(std::vector<T> & image, size_t cols, uint wx, uint wy,
+             Compare comp = Compare())
+        : outcols(cols - wx + 1), outrows(image.size() / cols - wy + 1),
+          maxvalues(hasmax(Sides) ? outcols * outrows : 0),
+          minvalues(hasmin(Sides) ? outcols * outrows : 0) {
+        filter(image.data(), cols, image.size() / cols, cols, wx, wy,
+               maxvalues.data(), minvalues.data(), outcols, comp);
+    }
+
+    /**
+     * Filters the rows x cols image, whose row y starts at image + y * stride,
+     * into (rows - wy + 1) x (cols - wx + 1) outputs, whose row y starts at
+     * maxvalues + y * outstride (and likewise for minvalues).
+     */
+    static void filter(const T * image, size_t cols, size_t rows,
+                       size_t stride, uint wx, uint wy, T * maxvalues,
+                       T * minvalues, size_t outstride,
+                       Compare comp = Compare(),
+                       size_t tilebytes = defaulttilebytes) {
+        filterworkspace<T> ws;
+        filter(image, cols, rows, stride, wx, wy, maxvalues, minvalues,
+               outstride, ws, comp, tilebytes);
+    }
+    static void filter(const T * image, size_t cols, size_t rows,
+                       size_t stride, uint wx, uint wy, T * maxvalues,
+                       T * minvalues, size_t outstride, filterworkspace<T> & ws,
+                       Compare comp = Compare(),
+                       size_t tilebytes = defaulttilebytes) {
+        const size_t outcols = cols - wx + 1;
+        const size_t perlane =
+            sizeof(T) * (wy + 3) * (hasmax(Sides) + hasmin(Sides));
+        const size_t tile =
+            std::min(outcols, std::max<size_t>(64, tilebytes / perlane));
+        std::vector<T> rowmax(hasmax(Sides) ? tile : 0);
+        std::vector<T> rowmin(hasmin(Sides) ? tile : 0);
+        for (size_t x0 = 0; x0 < outcols; x0 += tile) {
+            const uint tw = static_cast<uint>(std::min(tile, outcols - x0));
+            // an untracked side gets no lanes and is never updated
+            vanHerkmultilanestreaming<T, Compare, minmaxsides::maxonly> maxcol(
+                wy, hasmax(Sides) ? tw : 0, comp);
+            vanHerkmultilanestreaming<T, Compare, minmaxsides::minonly> mincol(
+                wy, hasmin(Sides) ? tw : 0, comp);
+            for (size_t y = 0; y < rows; ++y) {
+                RowFilter::filter(image + y * stride + x0, tw + wx - 1, wx,
+                                  hasmax(Sides) ? rowmax.data() : nullptr,
+                                  hasmin(Sides) ? rowmin.data() : nullptr, ws,
+                                  comp);
+                if (hasmax(Sides))
+                    maxcol.update(rowmax.data());
+                if (hasmin(Sides))
+                    mincol.update(rowmin.data());
+                if (y + 1 < wy)
+                    continue;
+                const size_t out = (y + 1 - wy) * outstride + x0;
+                if (hasmax(Sides))
+                    std::copy(maxcol.max(), maxcol.max() + tw,
+                              maxvalues + out);
+                if (hasmin(Sides))
+                    std::copy(mincol.min(), mincol.min() + tw,
+                              minvalues + out);
+            }
+        }
+    }
+    std::vector<T> & getmaxvalues() {
+        return maxvalues;
+    }
+    std::vector<T> & getminvalues() {
+        return minvalues;
+    }
+    size_t outcols;
+    size_t outrows;
+    std::vector<T> maxvalues; // outrows rows of outcols values
+    std::vector<T> minvalues;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #if __cplusplus > 199711L
+	#include <type_traits> // For std::decay
 	#include <utility> // For std::forward
 #endif
 
@@ -146,14 +147,14 @@ namespace mono_wedge
 		wedge.erase(
 			mono_wedge_search(wedge.begin(), wedge.end(), value, comp),
 			wedge.end());
-		wedge.push_back(std::forward(value));
+		wedge.push_back(std::forward<T>(value));
 	}
 
-	template<class Wedge, class T, class Compare>
-	void min_wedge_update(Wedge &wedge, T &&value)    {mono_wedge_update(wedge, std::forward(value), std::less<T>());}
+	template<class Wedge, class T>
+	void min_wedge_update(Wedge &wedge, T &&value)    {mono_wedge_update(wedge, std::forward<T>(value), std::less<typename std::decay<T>::type>());}
 
-	template<class Wedge, class T, class Compare>
-	void max_wedge_update(Wedge &wedge, T &&value)    {mono_wedge_update(wedge, std::forward(value), std::greater<T>());}
+	template<class Wedge, class T>
+	void max_wedge_update(Wedge &wedge, T &&value)    {mono_wedge_update(wedge, std::forward<T>(value), std::greater<typename std::decay<T>::type>());}
 #endif
 }
 
@@ -0,0 +1,145 @@
+/**
+ * Streaming maximum-minimum filter over many independent series at once.
+ *
+ * Each tick supplies one value per lane (channel); all lanes share the same
+ * window width. Lanes are stored as structure-of-arrays so that every step
+ * below is a straight loop over lanes that the compiler vectorizes, and the
+ * per-tick cost scales with the number of lanes divided by the SIMD width.
+ *
+ * This is the van Herk/Gil-Werman construction made streaming: time is cut
+ * into blocks of width ticks. For the block in progress we keep the running
+ * max (S). Once a block is complete its raw values are turned, in place,
+ * into suffix maxima (R). At offset o of the next block the window covers
+ * the tail of the previous block from o + 1 on, plus the head of the
+ * current block up to o, so the answer is max(R[o + 1], S). The raw value
+ * of tick o overwrites R[o], which is no longer needed, so one buffer of
+ * width rows suffices. The suffix pass costs width rows once every width
+ * ticks: amortized O(1) per tick, with no data-dependent branches.
+ */
+
+#ifndef MULTILANE_H
+#define MULTILANE_H
+
+#include <functional>
+#include <vector>
+
+#include "common.h"
+
+// With Sides other than both, the untracked side keeps no state at all.
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class vanHerkmultilanestreaming {
+public:
+    vanHerkmultilanestreaming(uint width, uint lanes, Compare c = Compare())
+        : maxrows(hasmax(Sides) ? width * lanes : 0),
+          minrows(hasmin(Sides) ? width * lanes : 0),
+          maxrun(hasmax(Sides) ? lanes : 0), minrun(hasmin(Sides) ? lanes : 0),
+          maxout(hasmax(Sides) ? lanes : 0), minout(hasmin(Sides) ? lanes : 0),
+          ww(width), nl(lanes), offset(0), primed(false), comp(c) {}
+
+    // values holds one new sample per lane
+    void update(const T * values) {
+        if (hasmax(Sides))
+            step(maxrows.data(), maxrun.data(), maxout.data(), values,
+                 maxcomp());
+        if (hasmin(Sides))
+            step(minrows.data(), minrun.data(), minout.data(), values,
+                 mincomp());
+        if (++offset == ww) {
+            // the block is complete: turn it into suffix maxima/minima
+            if (hasmax(Sides))
+                suffixes(maxrows.data(), maxcomp());
+            if (hasmin(Sides))
+                suffixes(minrows.data(), mincomp());
+            offset = 0;
+            primed = true;
+        }
+    }
+
+    // one result per lane, valid until the next update
+    const T * max() const {
+        return maxout.data();
+    }
+    const T * min() const {
+        return minout.data();
+    }
+    T max(uint lane) const {
+        return maxout[lane];
+    }
+    T min(uint lane) const {
+        return minout[lane];
+    }
+    uint lanes() const {
+        return nl;
+    }
+
+    // "better(a, b)" is true when b beats a on the side being computed
+    struct maxbetter {
+        Compare comp;
+        bool operator()(const T & a, const T & b) const {
+            return comp(a, b);
+        }
+    };
+    struct minbetter {
+        Compare comp;
+        bool operator()(const T & a, const T & b) const {
+            return comp(b, a);
+        }
+    };
+    maxbetter maxcomp() const {
+        return maxbetter{comp};
+    }
+    minbetter mincomp() const {
+        return minbetter{comp};
+    }
+
+    // one side of update(): running value, output, raw value into its row
+    template <typename Better>
+    void step(T * rows, T * run, T * out, const T * values,
+              Better better) const {
+        T * const row = rows + offset * nl;
+        if (offset == 0) {
+            for (uint l = 0; l < nl; ++l)
+                run[l] = values[l];
+        } else {
+            for (uint l = 0; l < nl; ++l)
+                run[l] = better(run[l], values[l]) ? values[l] : run[l];
+        }
+        if (primed && offset + 1 < ww) {
+            // the modulo never wraps here; it keeps GCC's -Warray-bounds
+            // from flagging width 1, where this branch is dead
+            const T * const next = rows + (offset + 1) % ww * nl;
+            for (uint l = 0; l < nl; ++l)
+                out[l] = better(next[l], run[l]) ? run[l] : next[l];
+        } else {
+            for (uint l = 0; l < nl; ++l)
+                out[l] = run[l];
+        }
+        for (uint l = 0; l < nl; ++l)
+            row[l] = values[l];
+    }
+
+    template <typename Better>
+    void suffixes(T * rows, Better better) const {
+        for (uint k = ww - 1; k-- > 0;) {
+            T * const rk = rows + k * nl;
+            const T * const rk1 = rk + nl;
+            for (uint l = 0; l < nl; ++l)
+                rk[l] = better(rk[l], rk1[l]) ? rk1[l] : rk[l];
+        }
+    }
+
+    std::vector<T> maxrows; // width rows of nl lanes
+    std::vector<T> minrows;
+    std::vector<T> maxrun;
+    std::vector<T> minrun;
+    std::vector<T> maxout;
+    std::vector<T> minout;
+    uint ww;
+    uint nl;
+    uint offset;
+    bool primed;
+    Compare comp;
+};
+
+#endif
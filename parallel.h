@@ -0,0 +1,98 @@
+/**
+ * Multi-threaded offline filtering of large arrays.
+ *
+ * The n - width + 1 outputs are split into one contiguous range per thread.
+ * The thread producing outputs [begin, end) reads the input range
+ * [begin, end + width - 1), so consecutive chunks overlap by width - 1
+ * samples. Every window is computed from its own samples only, hence the
+ * result is the same as a serial run, and each thread writes straight into
+ * its slice of the shared output arrays.
+ *
+ * Any filter with a static filter(array, n, width, maxvalues, minvalues)
+ * member can be driven this way. With a max-only or min-only filter the
+ * unused output pointer may be null.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "runningmaxmin.h"
+
+// Number of threads used when none is requested (at least one).
+inline uint defaultthreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// output slice starting at begin, keeping null (untracked side) as is
+template <typename T>
+T * outputslice(T * values, size_t begin) {
+    return values == nullptr ? nullptr : values + begin;
+}
+
+/**
+ * Runs Filter over array[0, n) with up to 'threads' threads. Chunks are kept
+ * at least 'minchunk' outputs (and four windows) long so that the overlap
+ * and thread start-up stay negligible; short inputs run serially.
+ */
+template <typename Filter, typename T>
+void parallelfilter(const T * array, size_t n, uint width, T * maxvalues,
+                    T * minvalues, uint threads = defaultthreads(),
+                    size_t minchunk = 1 << 16) {
+    const size_t outputs = n - width + 1;
+    const size_t chunk = std::max<size_t>(minchunk, 4 * size_t(width));
+    const size_t nchunks =
+        std::max<size_t>(1, std::min<size_t>(threads, outputs / chunk));
+    if (nchunks == 1) {
+        Filter::filter(array, n, width, maxvalues, minvalues);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t + 1 < nchunks; ++t) {
+        const size_t begin = outputs * t / nchunks;
+        const size_t end = outputs * (t + 1) / nchunks;
+        workers.emplace_back([=] {
+            Filter::filter(array + begin, end - begin + width - 1, width,
+                           outputslice(maxvalues, begin),
+                           outputslice(minvalues, begin));
+        });
+    }
+    // the calling thread takes the last chunk
+    const size_t begin = outputs * (nchunks - 1) / nchunks;
+    Filter::filter(array + begin, n - begin, width,
+                   outputslice(maxvalues, begin),
+                   outputslice(minvalues, begin));
+    for (std::thread & w : workers)
+        w.join();
+}
+
+/**
+ * minmaxfilter wrapper over parallelfilter, e.g.,
+ * parallelmaxmin<float, lemiremaxmin<float>> P(data, width, 8);
+ */
+template <typename T, typename Filter>
+class parallelmaxmin : public minmaxfilter<T> {
+public:
+    parallelmaxmin(std::vector<T> & array, uint width,
+                   uint threads = defaultthreads(),
+                   size_t minchunk = 1 << 16)
+        : maxvalues(array.size() - width + 1),
+          minvalues(array.size() - width + 1) {
+        parallelfilter<Filter>(array.data(), array.size(), width,
+                               maxvalues.data(), minvalues.data(), threads,
+                               minchunk);
+    }
+    std::vector<T> & getmaxvalues() {
+        return maxvalues;
+    }
+    std::vector<T> & getminvalues() {
+        return minvalues;
+    }
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
+};
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * Index for arbitrary range maximum-minimum queries over a stored array:
+ * max and min of array[begin, end) for any begin < end.
+ *
+ * The array is cut into blocks of 2^blockbits values. As in the van
+ * Herk/Gil-Werman filter, each block stores its prefix and suffix maxima, so
+ * that a range crossing a block boundary is the max of a suffix, a prefix
+ * and the whole blocks in between. The whole blocks are answered by a
+ * sparse table over the block maxima: level k holds the max of each run of
+ * 2^k blocks, and any run of blocks is covered by two overlapping runs of
+ * the largest power of two that fits. Every query crossing a block boundary
+ * thus takes at most four comparisons. Ranges within one block that touch
+ * neither of its ends are scanned (fewer than 2^blockbits values).
+ *
+ * Per side, the index takes 2n values plus (n / 32) log2(n / 32) for the
+ * table. It refers to the array, which must outlive it and not change.
+ */
+
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "runningmaxmin.h"
+
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class rangemaxmin {
+public:
+    static const uint blockbits = 5;
+
+    rangemaxmin(const T * array, size_t n, Compare c = Compare())
+        : data(array), size(n), comp(c) {
+        if (hasmax(Sides))
+            build(up, maxcomp());
+        if (hasmin(Sides))
+            build(lo, mincomp());
+    }
+    explicit rangemaxmin(const std::vector<T> & array, Compare c = Compare())
+        : rangemaxmin(array.data(), array.size(), c) {}
+    // the index does not copy the array
+    explicit rangemaxmin(std::vector<T> &&, Compare = Compare()) = delete;
+
+    // extremum of array[begin, end), begin < end <= n
+    T max(size_t begin, size_t end) const {
+        return query(up, begin, end, maxcomp());
+    }
+    T min(size_t begin, size_t end) const {
+        return query(lo, begin, end, mincomp());
+    }
+
+    /**
+     * Answers count queries: maxvalues[q] and minvalues[q] get the max and
+     * min of array[begins[q], ends[q]). Either output may be null.
+     */
+    void query(const size_t * begins, const size_t * ends, size_t count,
+               T * maxvalues, T * minvalues) const {
+        if (hasmax(Sides) && maxvalues != nullptr)
+            for (size_t q = 0; q < count; ++q)
+                maxvalues[q] = max(begins[q], ends[q]);
+        if (hasmin(Sides) && minvalues != nullptr)
+            for (size_t q = 0; q < count; ++q)
+                minvalues[q] = min(begins[q], ends[q]);
+    }
+
+private:
+    // "better(a, b)" is true when b beats a on the side being computed
+    struct maxbetter {
+        Compare comp;
+        bool operator()(const T & a, const T & b) const {
+            return comp(a, b);
+        }
+    };
+    struct minbetter {
+        Compare comp;
+        bool operator()(const T & a, const T & b) const {
+            return comp(b, a);
+        }
+    };
+    maxbetter maxcomp() const {
+        return maxbetter{comp};
+    }
+    minbetter mincomp() const {
+        return minbetter{comp};
+    }
+
+    struct side {
+        std::vector<T> prefix; // best of array[block start, i]
+        std::vector<T> suffix; // best of array[i, block end)
+        // level k, at k * blocks: best of blocks [b, b + 2^k)
+        std::vector<T> table;
+        size_t blocks;
+    };
+
+    template <typename Better>
+    void build(side & s, Better better) {
+        const size_t block = size_t(1) << blockbits;
+        s.prefix.resize(size);
+        s.suffix.resize(size);
+        for (size_t start = 0; start < size; start += block) {
+            const size_t end = std::min(start + block, size);
+            s.prefix[start] = data[start];
+            for (size_t i = start + 1; i < end; ++i)
+                s.prefix[i] = better(s.prefix[i - 1], data[i])
+                                  ? data[i]
+                                  : s.prefix[i - 1];
+            s.suffix[end - 1] = data[end - 1];
+            for (size_t i = end - 1; i-- > start;)
+                s.suffix[i] = better(s.suffix[i + 1], data[i])
+                                  ? data[i]
+                                  : s.suffix[i + 1];
+        }
+        s.blocks = (size + block - 1) >> blockbits;
+        const int levels = s.blocks == 0 ? 0 : highestbit(s.blocks) + 1;
+        s.table.resize(s.blocks * levels);
+        for (size_t b = 0; b < s.blocks; ++b)
+            s.table[b] = s.suffix[b << blockbits];
+        for (int k = 1; k < levels; ++k) {
+            const T * below = &s.table[(k - 1) * s.blocks];
+            T * level = &s.table[k * s.blocks];
+            const size_t half = size_t(1) << (k - 1);
+            for (size_t b = 0; b + 2 * half <= s.blocks; ++b)
+                level[b] = better(below[b], below[b + half]) ? below[b + half]
+                                                             : below[b];
+        }
+    }
+
+    template <typename Better>
+    T query(const side & s, size_t begin, size_t end, Better better) const {
+        const size_t last = end - 1;
+        const size_t first = begin >> blockbits, final = last >> blockbits;
+        if (first == final) {
+            if ((begin & ((size_t(1) << blockbits) - 1)) == 0)
+                return s.prefix[last];
+            if (((end & ((size_t(1) << blockbits) - 1)) == 0) || (end == size))
+                return s.suffix[begin];
+            T best = data[begin];
+            for (size_t i = begin + 1; i < end; ++i)
+                best = better(best, data[i]) ? data[i] : best;
+            return best;
+        }
+        T best = better(s.suffix[begin], s.prefix[last]) ? s.prefix[last]
+                                                         : s.suffix[begin];
+        if (final > first + 1) {
+            const size_t count = final - first - 1;
+            const int k = highestbit(count);
+            const T * level = &s.table[k * s.blocks];
+            const T & left = level[first + 1];
+            const T & right = level[final - (size_t(1) << k)];
+            const T & whole = better(left, right) ? right : left;
+            best = better(best, whole) ? whole : best;
+        }
+        return best;
+    }
+
+    const T * data;
+    size_t size;
+    Compare comp;
+    side up;
+    side lo;
+};
+
+#endif
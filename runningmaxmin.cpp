@@ -1,181 +1,405 @@
+#include "adaptive.h"
+#include "filterbank.h"
+#include "generators.h"
+#include "harness.h"
+#include "mappedio.h"
+#include "maxmin2d.h"
+#include "multilane.h"
+#include "parallel.h"
+#include "rangeindex.h"
 #include "runningmaxmin.h"
+#include "textinput.h"
+#include "vanherksimd.h"
 
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <ctime>
+#include <fstream>
 #include <iomanip>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
 
 
+// all the random data of the benchmark, seeded by --seed
+xoshiro256 & datarng() {
+    static xoshiro256 rng;
+    return rng;
+}
+
+std::vector<floattype> getsignal(signalshape shape, double parameter,
+                                 const char * name, size_t size) {
+    return generate(signalspec{shape, parameter, name}, size, datarng());
+}
+
 std::vector<floattype> getwhite(uint size) {
-    std::vector<floattype> data(size);
-    for (uint k = 0; k < size; ++k)
-        data[k] = (1.0 * rand() / (RAND_MAX)) - 0.5;
-    return data;
+    return getsignal(signalshape::white, 0, "white", size);
 }
 
 std::vector<floattype> getrandomwalk(uint size) {
-    std::vector<floattype> data(size);
-    data[0] = 0.0;
-    for (uint k = 1; k < size; ++k)
-        data[k] = (1.0 * rand() / (RAND_MAX)) - 0.5 + data[k - 1];
-    return data;
-}
-
-std::vector<floattype> getcin() {
-    float val;
-    std::cin >> val;
-    std::vector<floattype> v;
-    while (std::cin) {
-        v.push_back(val);
-        std::cin >> val;
-    }
-    std::cout << "# Read " << v.size() << " data points. " << std::endl;
+    return getsignal(signalshape::walk, 0, "walk", size);
+}
+
+// period > 0, checked when parsing --sine
+std::vector<floattype> getsine(uint size, floattype period) {
+    return getsignal(signalshape::sine, period, "sine", size);
+}
+
+// parses field 'column' of each line of the standard input, reporting the
+// parse time apart from the filter timings
+std::vector<floattype> getcin(uint column = 0, uint threads = 1,
+                              std::ostream & log = std::cout) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<char> text = readall(stdin);
+    const auto read = std::chrono::steady_clock::now();
+    std::vector<floattype> v = parsecolumn<floattype>(
+        text.data(), text.data() + text.size() - 1, column, threads);
+    const auto parsed = std::chrono::steady_clock::now();
+    const double readtime = std::chrono::duration<double>(read - start).count();
+    const double parsetime =
+        std::chrono::duration<double>(parsed - read).count();
+    log << "# Read " << v.size() << " data points. " << std::endl;
+    log << "# read " << text.size() - 1 << " bytes in " << readtime
+        << " s, parsed in " << parsetime << " s ("
+        << (text.size() - 1) / parsetime / 1e6 << " MB/s, " << threads
+        << " thread(s))" << std::endl;
     return v;
 }
 
-void compareallalgos(std::vector<floattype> & data,
+template <typename T>
+void compareallalgos(std::vector<T> & data,
                      std::vector<double> & timings, uint width, bool doslow) {
-    if (timings.size() < 8)
-        timings = std::vector<double>(8, 0.0);
+    if (timings.size() < 13)
+        timings = std::vector<double>(13, 0.0);
     clock_t start, finish;
     start = clock();
     if (doslow)
-        slowmaxmin A(data, width);
+        slowmaxmin<T> A(data, width);
     finish = clock();
     timings[0] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    vanHerkGilWermanmaxmin B(data, width);
+    vanHerkGilWermanmaxmin<T> B(data, width);
     finish = clock();
     timings[1] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    lemiremaxmin C(data, width);
+    lemiremaxmin<T> C(data, width);
     finish = clock();
     timings[2] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    GilKimmel D(data, width);
+    GilKimmel<T> D(data, width);
     finish = clock();
     timings[3] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    if (width < sizeof(unsigned long) * 8)
-        lemirebitmapmaxmin BL(data, width);
+    lemirebitmapmaxmin<T> BL(data, width);
     finish = clock();
     timings[4] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    simplelemiremaxmin F(data, width);
+    simplelemiremaxmin<T> F(data, width);
     finish = clock();
     timings[5] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    lemiremaxminwrap Cw(data, width);
+    lemiremaxminwrap<T> Cw(data, width);
     finish = clock();
     timings[6] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
     start = clock();
-    monowedgewrap Mw(data, width);
+    monowedgewrap<T> Mw(data, width);
     finish = clock();
     timings[7] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    start = clock();
+    vanHerkGilWermanmaxminsimd<T> Bv(data, width);
+    finish = clock();
+    timings[8] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    start = clock();
+    {
+        // packetized ingest: blocks of 1000 samples through update_batch
+        std::vector<T> maxvalues(data.size()), minvalues(data.size());
+        lemiremaxmintruestreaming<T> lts(width);
+        for (size_t i = 0; i < data.size(); i += 1000)
+            lts.update_batch(&data[i], std::min<size_t>(1000, data.size() - i),
+                             &maxvalues[i], &minvalues[i]);
+    }
+    finish = clock();
+    timings[9] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    // the ring-buffer filters above, on std::deque for comparison
+    start = clock();
+    lemiremaxmin<T, std::less<T>, minmaxsides::both, std::deque<int>> Cd(
+        data, width);
+    finish = clock();
+    timings[10] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    start = clock();
+    simplelemiremaxmin<T, std::less<T>, minmaxsides::both, std::deque<int>> Fd(
+        data, width);
+    finish = clock();
+    timings[11] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    start = clock();
+    monowedgewrap<T, std::less<T>, minmaxsides::both, std::deque<Sample<T>>>
+        Mwd(data, width);
+    finish = clock();
+    timings[12] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
 }
 
-void process(std::vector<floattype> & data, uint width = 30, uint times = 1,
+// the columns of compareallalgos
+void printtimings(const std::vector<double> & timings) {
+    static const char * const names[] = {
+        "slow",        "vanHerk",      "lemire",      "gilkimmel",
+        "bitmap",      "simplelemire", "lemirew",     "monowedge",
+        "vanHerksimd", "lemirebatch",  "lemiredeque", "simpledeque",
+        "monowedgedeque"};
+    for (const char * name : names)
+        std::cout << std::setw(15) << name;
+    std::cout << std::endl;
+    for (double t : timings)
+        std::cout << std::setw(15) << t;
+    std::cout << std::endl;
+}
+
+template <typename T>
+void process(std::vector<T> & data, uint width = 30, uint times = 1,
              bool doslow = true) {
     std::vector<double> timings;
     for (uint i = 0; i < times; ++i) {
         compareallalgos(data, timings, width, doslow);
     }
-    std::cout << "#\tslow\t\tvanHerk\t\tlemire\tsimplelemire\t\tgilkimmel"
-              << std::endl;
-    std::cout << "\t" << timings[0] << "\t" << timings[1] << "\t" << timings[2]
-              << "\t" << timings[5] << "\t\t" << timings[3] << std::endl;
+    printtimings(timings);
 }
 
+template <typename T>
 void timings(uint width = 50, uint size = 10000, uint times = 500,
              bool doslow = true) {
+    // generated once, outside the timed repetitions
+    std::vector<T> data = convert<T>(getwhite(size));
     std::vector<double> timings;
-    for (uint i = 0; i < times; ++i) {
-        std::vector<floattype> data = getwhite(size);
+    for (uint i = 0; i < times; ++i)
         compareallalgos(data, timings, width, doslow);
-    }
-    std::cout << std::setw(15) << "slow";
-    std::cout << std::setw(15) << "vanHerk";
-    std::cout << std::setw(15) << "lemire";
-    std::cout << std::setw(15) << "gilkimmel";
-    std::cout << std::setw(15) << "bitmap";
-    std::cout << std::setw(15) << "simplelemire";
-    std::cout << std::setw(15) << "lemirew";
-    std::cout << std::setw(15) << "monowedge";
-    std::cout << std::endl;
-    for (int i = 0; i <= 7; ++i) {
-        std::cout << std::setw(15) << timings[i];
-    }
-    std::cout << std::endl;
+    printtimings(timings);
 }
 
+template <typename T>
 void walktimings(uint width = 50, uint size = 10000, uint times = 500,
                  bool doslow = true) {
+    // generated once, outside the timed repetitions
+    std::vector<T> data = convert<T>(getrandomwalk(size));
     std::vector<double> timings;
-    for (uint i = 0; i < times; ++i) {
-        std::vector<floattype> data = getrandomwalk(size);
+    for (uint i = 0; i < times; ++i)
         compareallalgos(data, timings, width, doslow);
-    }
-    std::cout << std::setw(15) << "slow";
-    std::cout << std::setw(15) << "vanHerk";
-    std::cout << std::setw(15) << "lemire";
-    std::cout << std::setw(15) << "gilkimmel";
-    std::cout << std::setw(15) << "bitmap";
-    std::cout << std::setw(15) << "simplelemire";
-    std::cout << std::setw(15) << "lemirew";
-    std::cout << std::setw(15) << "monowedge";
-    std::cout << std::endl;
-    for (int i = 0; i <= 7; ++i) {
-        std::cout << std::setw(15) << timings[i];
-    }
-    std::cout << std::endl;
+    printtimings(timings);
 }
 
+template <typename T>
 void sinetimings(uint width = 50, uint size = 10000, floattype period = 500.0,
                  uint times = 500, bool doslow = true) {
+    // generated once, outside the timed repetitions
+    std::vector<T> data = convert<T>(getsine(size, period));
     std::vector<double> timings;
-    for (uint i = 0; i < times; ++i) {
-        std::vector<floattype> data(size);
-        for (uint j = 0; j < size; ++j)
-            data[j] = sin(2 * M_PI * j / period);
+    for (uint i = 0; i < times; ++i)
         compareallalgos(data, timings, width, doslow);
+    printtimings(timings);
+}
+
+// one streaming filter per channel, data holding ticks rows of lanes values
+template <typename Filter, typename T>
+double channeltime(const std::vector<T> & data, uint width, uint lanes,
+                   uint ticks, uint & sink) {
+    clock_t start = clock();
+    {
+        std::vector<Filter *> single;
+        for (uint l = 0; l < lanes; ++l)
+            single.push_back(new Filter(width));
+        for (uint t = 0; t < ticks; ++t)
+            for (uint l = 0; l < lanes; ++l) {
+                single[l]->update(data[t * lanes + l]);
+                sink ^= single[l]->max() < single[l]->min();
+            }
+        for (uint l = 0; l < lanes; ++l)
+            delete single[l];
+    }
+    clock_t finish = clock();
+    return static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Many channels sharing one window: one scalar streaming filter per channel
+ * (regular and compact queues) against a single multi-lane filter. The noise is generated up front.
+ */
+template <typename T>
+void lanetimings(uint width, uint lanes, uint ticks, uint times) {
+    std::vector<T> data = convert<T>(getwhite(ticks * lanes));
+    double scalartime = 0, compacttime = 0, multitime = 0;
+    uint sink = 0;
+    for (uint r = 0; r < times; ++r) {
+        scalartime += channeltime<lemiremaxmintruestreaming<T>>(
+            data, width, lanes, ticks, sink);
+        compacttime += channeltime<lemiremaxmintruestreaming<
+            T, std::less<T>, minmaxsides::both, argties::any, compactqueue<T>>>(
+            data, width, lanes, ticks, sink);
+        clock_t start = clock();
+        {
+            vanHerkmultilanestreaming<T> multi(width, lanes);
+            for (uint t = 0; t < ticks; ++t) {
+                multi.update(&data[t * lanes]);
+                sink ^= multi.max()[t % lanes] < multi.min()[t % lanes];
+            }
+        }
+        clock_t finish = clock();
+        multitime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    }
+    std::cout << std::setw(15) << "lemirew" << std::setw(15) << "compact"
+              << std::setw(15) << "multilane" << std::endl;
+    std::cout << std::setw(15) << scalartime << std::setw(15) << compacttime
+              << std::setw(15) << multitime << (sink ? " " : "") << std::endl;
+}
+
+template <typename T, typename Filter>
+double paralleltime(std::vector<T> & data, uint width, uint threads) {
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    parallelfilter<Filter>(data.data(), data.size(), width, maxvalues.data(),
+                           minvalues.data(), threads);
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// the usual workaround: filter the rows, transpose, filter the rows again
+template <typename T>
+void transposedfilter(const std::vector<T> & image, size_t cols, size_t rows,
+                      uint wx, uint wy, std::vector<T> & maxvalues,
+                      std::vector<T> & minvalues) {
+    const size_t outcols = cols - wx + 1, outrows = rows - wy + 1;
+    std::vector<T> rowmax(rows * outcols), rowmin(rows * outcols);
+    for (size_t y = 0; y < rows; ++y)
+        vanHerkGilWermanmaxmin<T>::filter(&image[y * cols], cols, wx,
+                                          &rowmax[y * outcols],
+                                          &rowmin[y * outcols]);
+    std::vector<T> tmax(rows * outcols), tmin(rows * outcols);
+    for (size_t y = 0; y < rows; ++y)
+        for (size_t x = 0; x < outcols; ++x) {
+            tmax[x * rows + y] = rowmax[y * outcols + x];
+            tmin[x * rows + y] = rowmin[y * outcols + x];
+        }
+    std::vector<T> colmax(outcols * outrows), colmin(outcols * outrows);
+    typedef vanHerkGilWermanmaxmin<T, std::less<T>, minmaxsides::maxonly>
+        maxfilter;
+    typedef vanHerkGilWermanmaxmin<T, std::less<T>, minmaxsides::minonly>
+        minfilter;
+    for (size_t x = 0; x < outcols; ++x)
+        maxfilter::filter(&tmax[x * rows], rows, wy, &colmax[x * outrows],
+                          nullptr);
+    for (size_t x = 0; x < outcols; ++x)
+        minfilter::filter(&tmin[x * rows], rows, wy, nullptr,
+                          &colmin[x * outrows]);
+    for (size_t x = 0; x < outcols; ++x)
+        for (size_t y = 0; y < outrows; ++y) {
+            maxvalues[y * outcols + x] = colmax[x * outrows + y];
+            minvalues[y * outcols + x] = colmin[x * outrows + y];
+        }
+}
+
+/**
+ * width by width windows over a cols x rows white-noise image: row passes
+ * plus transposes against maxmin2d (scalar and SIMD row pass).
+ */
+template <typename T>
+void imagetimings(size_t cols, size_t rows, uint width, uint times) {
+    std::vector<T> image = convert<T>(getwhite(cols * rows));
+    const size_t outputs = (cols - width + 1) * (rows - width + 1);
+    std::vector<T> maxvalues(outputs), minvalues(outputs);
+    std::vector<double> timings(3, 0.0);
+    for (uint i = 0; i < times; ++i) {
+        std::chrono::steady_clock::time_point t0 =
+            std::chrono::steady_clock::now();
+        transposedfilter(image, cols, rows, width, width, maxvalues,
+                         minvalues);
+        std::chrono::steady_clock::time_point t1 =
+            std::chrono::steady_clock::now();
+        maxmin2d<T>::filter(image.data(), cols, rows, cols, width, width,
+                            maxvalues.data(), minvalues.data(),
+                            cols - width + 1);
+        std::chrono::steady_clock::time_point t2 =
+            std::chrono::steady_clock::now();
+        maxmin2d<T, std::less<T>, minmaxsides::both,
+                 vanHerkGilWermanmaxminsimd<T>>::filter(image.data(), cols,
+                                                        rows, cols, width,
+                                                        width,
+                                                        maxvalues.data(),
+                                                        minvalues.data(),
+                                                        cols - width + 1);
+        std::chrono::steady_clock::time_point t3 =
+            std::chrono::steady_clock::now();
+        timings[0] += std::chrono::duration<double>(t1 - t0).count();
+        timings[1] += std::chrono::duration<double>(t2 - t1).count();
+        timings[2] += std::chrono::duration<double>(t3 - t2).count();
+    }
+    std::cout << std::setw(15) << "transpose" << std::setw(15) << "maxmin2d"
+              << std::setw(15) << "maxmin2dsimd" << std::endl;
+    for (int i = 0; i < 3; ++i)
+        std::cout << std::setw(15) << timings[i];
+    std::cout << std::endl;
+}
+
+/**
+ * Serial (one thread) against parallel (threads) runs of the offline filters.
+ * Wall-clock time is reported since clock() adds up the CPU time of all
+ * threads.
+ */
+template <typename T>
+void threadtimings(std::vector<T> & data, uint width, uint threads,
+                   uint times) {
+    std::vector<double> timings(8, 0.0);
+    for (uint i = 0; i < times; ++i) {
+        timings[0] += paralleltime<T, lemiremaxmin<T>>(data, width, 1);
+        timings[1] += paralleltime<T, lemiremaxmin<T>>(data, width, threads);
+        timings[2] +=
+            paralleltime<T, vanHerkGilWermanmaxmin<T>>(data, width, 1);
+        timings[3] +=
+            paralleltime<T, vanHerkGilWermanmaxmin<T>>(data, width, threads);
+        timings[4] += paralleltime<T, GilKimmel<T>>(data, width, 1);
+        timings[5] += paralleltime<T, GilKimmel<T>>(data, width, threads);
+        timings[6] +=
+            paralleltime<T, vanHerkGilWermanmaxminsimd<T>>(data, width, 1);
+        timings[7] += paralleltime<T, vanHerkGilWermanmaxminsimd<T>>(
+            data, width, threads);
+    }
+    const char * names[] = {"lemire", "vanHerk", "gilkimmel", "vanHerksimd"};
+    for (int i = 0; i < 4; ++i) {
+        std::cout << std::setw(14) << names[i] << "/1";
+        std::cout << std::setw(14) << names[i] << "/" << threads;
     }
-    std::cout << std::setw(15) << "slow";
-    std::cout << std::setw(15) << "vanHerk";
-    std::cout << std::setw(15) << "lemire";
-    std::cout << std::setw(15) << "gilkimmel";
-    std::cout << std::setw(15) << "bitmap";
-    std::cout << std::setw(15) << "simplelemire";
-    std::cout << std::setw(15) << "lemirew";
-    std::cout << std::setw(15) << "monowedge";
     std::cout << std::endl;
     for (int i = 0; i <= 7; ++i) {
-        std::cout << std::setw(15) << timings[i];
+        std::cout << std::setw(16) << timings[i];
     }
     std::cout << std::endl;
 }
 
-void timingsline(std::vector<floattype> data, uint width = 30,
+template <typename T>
+void timingsline(std::vector<T> data, uint width = 30,
                  bool doslow = false) {
     std::cout << " width = " << width << std::endl;
     clock_t start, finish;
     start = clock();
     if (doslow)
         for (uint i = 0; i < 30; ++i)
-            slowmaxmin A(data, width);
+            slowmaxmin<T> A(data, width);
     finish = clock();
     std::cout << "slow = "
               << static_cast<double>(finish - start) / CLOCKS_PER_SEC
               << std::endl;
     start = clock();
     for (uint i = 0; i < 30; ++i)
-        vanHerkGilWermanmaxmin B(data, width);
+        vanHerkGilWermanmaxmin<T> B(data, width);
     finish = clock();
     std::cout << "vanHerk = "
               << static_cast<double>(finish - start) / CLOCKS_PER_SEC
               << std::endl;
     start = clock();
     for (uint i = 0; i < 30; ++i)
-        lemiremaxmin C(data, width);
+        lemiremaxmin<T> C(data, width);
     finish = clock();
     std::cout << "lemire = "
               << static_cast<double>(finish - start) / CLOCKS_PER_SEC
@@ -184,11 +408,156 @@ void timingsline(std::vector<floattype> data, uint width = 30,
 }
 
 /**
- * use in conjunction with
+ * Several widths over one stream: one streaming filter per width against a
+ * single filter bank, both reporting every width at every sample, and the
+ * bank fed without reporting (its cost per update).
+ */
+template <typename T>
+void banktimings(std::vector<T> & data, const std::vector<uint> & widths,
+                 uint times) {
+    double singletime = 0, banktime = 0, updatetime = 0;
+    uint sink = 0;
+    for (uint r = 0; r < times; ++r) {
+        clock_t start = clock();
+        {
+            std::vector<lemiremaxmintruestreaming<T> *> single;
+            for (uint width : widths)
+                single.push_back(new lemiremaxmintruestreaming<T>(width));
+            for (size_t i = 0; i < data.size(); ++i)
+                for (size_t k = 0; k < widths.size(); ++k) {
+                    single[k]->update(data[i]);
+                    sink ^= single[k]->max() < single[k]->min();
+                }
+            for (size_t k = 0; k < widths.size(); ++k)
+                delete single[k];
+        }
+        clock_t finish = clock();
+        singletime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        {
+            lemiremaxminbank<T> bank(widths);
+            for (size_t i = 0; i < data.size(); ++i) {
+                bank.update(data[i]);
+                for (size_t k = 0; k < widths.size(); ++k)
+                    sink ^= bank.max(k) < bank.min(k);
+            }
+        }
+        finish = clock();
+        banktime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        {
+            lemiremaxminbank<T> bank(widths);
+            for (size_t i = 0; i < data.size(); ++i)
+                bank.update(data[i]);
+            sink ^= bank.max(0) < bank.min(0);
+        }
+        finish = clock();
+        updatetime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    }
+    std::cout << std::setw(15) << "lemirew" << std::setw(15) << "bank"
+              << std::setw(15) << "bankupdate" << std::endl;
+    std::cout << std::setw(15) << singletime << std::setw(15) << banktime
+              << std::setw(15) << updatetime << (sink ? " " : "")
+              << std::endl;
+}
 
- | awk '{print $2}'
+/**
+ * Ad-hoc range queries of random lengths up to maxlength: a scan of each
+ * range against the range index (its construction timed apart).
  */
-int main(int params, char ** args) {
+template <typename T>
+void rangetimings(std::vector<T> & data, uint maxlength, uint queries,
+                  uint times) {
+    std::vector<size_t> begins(queries), ends(queries);
+    for (uint q = 0; q < queries; ++q) {
+        const size_t length =
+            1 + datarng().below(std::min<size_t>(maxlength, data.size()));
+        begins[q] = datarng().below(data.size() - length + 1);
+        ends[q] = begins[q] + length;
+    }
+    std::vector<T> maxvalues(queries), minvalues(queries);
+    double scantime = 0, buildtime = 0, querytime = 0;
+    uint sink = 0;
+    for (uint r = 0; r < times; ++r) {
+        clock_t start = clock();
+        for (uint q = 0; q < queries; ++q) {
+            T maxvalue = data[begins[q]], minvalue = data[begins[q]];
+            for (size_t i = begins[q] + 1; i < ends[q]; ++i) {
+                if (data[i] > maxvalue)
+                    maxvalue = data[i];
+                if (data[i] < minvalue)
+                    minvalue = data[i];
+            }
+            maxvalues[q] = maxvalue;
+            minvalues[q] = minvalue;
+        }
+        clock_t finish = clock();
+        scantime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        sink ^= maxvalues[r % queries] < minvalues[r % queries];
+        start = clock();
+        rangemaxmin<T> index(data);
+        finish = clock();
+        buildtime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        index.query(begins.data(), ends.data(), queries, maxvalues.data(),
+                    minvalues.data());
+        finish = clock();
+        querytime += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        sink ^= maxvalues[r % queries] < minvalues[r % queries];
+    }
+    std::cout << std::setw(15) << "scan" << std::setw(15) << "indexbuild"
+              << std::setw(15) << "indexquery" << std::endl;
+    std::cout << std::setw(15) << scantime << std::setw(15) << buildtime
+              << std::setw(15) << querytime << (sink ? " " : "") << std::endl;
+}
+
+/**
+ * Every stride-th window only: full outputs against the strided filters,
+ * which also need stride times less output memory.
+ */
+template <typename T>
+void stridetimings(std::vector<T> & data, uint width, uint stride,
+                   uint times) {
+    const size_t full = data.size() - width + 1;
+    const size_t count = stridedsize(data.size(), width, stride);
+    std::vector<T> maxvalues(full), minvalues(full);
+    std::vector<double> timings(4, 0.0);
+    for (uint r = 0; r < times; ++r) {
+        clock_t start = clock();
+        vanHerkGilWermanmaxmin<T>::filter(data.data(), data.size(), width,
+                                          maxvalues.data(), minvalues.data());
+        clock_t finish = clock();
+        timings[0] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        vanHerkGilWermanmaxmin<T>::filterstrided(data.data(), data.size(),
+                                                 width, stride,
+                                                 maxvalues.data(),
+                                                 minvalues.data());
+        finish = clock();
+        timings[1] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        lemiremaxminwrap<T>::filter(data.data(), data.size(), width,
+                                    maxvalues.data(), minvalues.data());
+        finish = clock();
+        timings[2] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+        start = clock();
+        lemiremaxminwrap<T>::filterstrided(data.data(), data.size(), width,
+                                           stride, maxvalues.data(),
+                                           minvalues.data());
+        finish = clock();
+        timings[3] += static_cast<double>(finish - start) / CLOCKS_PER_SEC;
+    }
+    std::cout << "# " << full << " windows, " << count << " reported"
+              << std::endl;
+    std::cout << std::setw(15) << "vanHerk" << std::setw(15) << "vanHerk/s"
+              << std::setw(15) << "lemirew" << std::setw(15) << "lemirew/s"
+              << std::endl;
+    for (int i = 0; i <= 3; ++i)
+        std::cout << std::setw(15) << timings[i];
+    std::cout << std::endl;
+}
+
+struct benchmarkoptions {
     int whitesize = 0;
     int walksize = 0;
     int times = 1;
@@ -196,15 +565,468 @@ int main(int params, char ** args) {
     floattype sineperiod = 0.0;
     int windowbegin = 10;
     int windowend = 11;
+    int lanes = 0;
+    int threads = 0;
+    int imagecols = 0;
+    int imagerows = 0;
+    std::vector<uint> bankwidths;
+    int ranges = 0;
+    int stride = 0;
+    int branches = 0; // samples per signal of the branch-miss comparison
+    int latency = 0;  // samples per signal of the per-update latency test
+    uint column = 0; // of the text read with --pipedata
+    uint parsethreads = 1;
+    std::string input; // raw binary file, filtered through mmap
+    std::string format = "float64";
+    std::string maxoutput;
+    std::string minoutput;
+    std::vector<signalspec> signals; // --data, of datasize samples each
+    int datasize = 0;
+    uint64_t seed = 1;
+    std::string type = "double";
+    std::string report; // text, csv or json: through the harness
+    std::string reportfile;
+    std::string calibrate;  // file to save the adaptive filter's table to
+    std::string crossovers; // file to load it from
     bool doslow = true;
     bool cininput = false;
-    std::vector<floattype> data(0);
+};
+
+/**
+ * Filters the raw binary file o.input (values of type T) over the window
+ * o.windowbegin into the binary files o.maxoutput and o.minoutput, of the
+ * same type; at least one of them must be given.
+ */
+template <typename T>
+int mapped(const benchmarkoptions & o) {
+    const uint width = o.windowbegin;
+    try {
+        mappedfile in(o.input);
+        const size_t n = in.size() / sizeof(T);
+        if (n < width) {
+            std::cerr << o.input << " holds fewer than " << width << " "
+                      << o.format << " values" << std::endl;
+            return -1;
+        }
+        const size_t bytes = (n - width + 1) * sizeof(T);
+        std::unique_ptr<mappedfile> maxout, minout;
+        if (!o.maxoutput.empty())
+            maxout.reset(new mappedfile(o.maxoutput, bytes));
+        if (!o.minoutput.empty())
+            minout.reset(new mappedfile(o.minoutput, bytes));
+        const auto start = std::chrono::steady_clock::now();
+        if (maxout && minout)
+            filtermapped<lemiremaxmin<T>, T>(in, maxout.get(), minout.get(),
+                                             width);
+        else if (maxout)
+            filtermapped<lemiremaxmin<T, std::less<T>, minmaxsides::maxonly>,
+                         T>(in, maxout.get(), nullptr, width);
+        else
+            filtermapped<lemiremaxmin<T, std::less<T>, minmaxsides::minonly>,
+                         T>(in, nullptr, minout.get(), width);
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        std::cout << "# window = " << width << ": filtered " << n << " "
+                  << o.format << " values in " << seconds << " s ("
+                  << in.size() / seconds / 1e6 << " MB/s)" << std::endl;
+    } catch (const std::system_error & e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// Filter::filter over data, into buffers and a workspace allocated once
+template <typename Filter, typename T>
+measurement measurefilter(const std::string & algorithm,
+                          const std::string & dataset,
+                          const std::vector<T> & data, uint width,
+                          const benchmarkoptions & o, perfcounters & counters) {
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    filterworkspace<T> ws;
+    return measure(
+        algorithm, dataset, o.type, width, data.size(), o.times,
+        [&] {
+            Filter::filter(data.data(), data.size(), width, maxvalues.data(),
+                           minvalues.data(), ws);
+        },
+        &counters);
+}
+
+// a Stream filter fed the whole of data per run, in blocks of 1000 samples
+template <typename Stream, typename T>
+measurement measurestream(const std::string & algorithm,
+                          const std::string & dataset,
+                          const std::vector<T> & data, uint width,
+                          const std::string & type, uint times,
+                          perfcounters & counters) {
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    Stream stream(width);
+    return measure(
+        algorithm, dataset, type, width, data.size(), times,
+        [&] {
+            for (size_t i = 0; i < data.size(); i += 1000)
+                stream.update_batch(&data[i],
+                                    std::min<size_t>(1000, data.size() - i),
+                                    &maxvalues[i], &minvalues[i]);
+        },
+        &counters);
+}
+
+// the streaming filter with its statistics, timed or not
+template <typename T, bool Timed>
+using counted =
+    lemiremaxmintruestreaming<T, std::less<T>, minmaxsides::both, argties::any,
+                              intfloatqueue<T>, filterstats<Timed>>;
+
+/**
+ * Times every filter over each dataset given (--white, --walk, --sine,
+ * --pipedata) and window through the harness, o.times repetitions each,
+ * and writes one record per algorithm, dataset and width in the o.report
+ * format to o.reportfile, or the standard output. Comments go to the
+ * standard error so that the report can be piped.
+ */
+template <typename T>
+int report(const benchmarkoptions & o) {
+    std::vector<std::pair<std::string, std::vector<T>>> datasets;
+    if (o.whitesize > 0)
+        datasets.emplace_back("white", convert<T>(getwhite(o.whitesize)));
+    if (o.walksize > 0)
+        datasets.emplace_back("walk", convert<T>(getrandomwalk(o.walksize)));
+    if (o.sinesize > 0)
+        datasets.emplace_back(
+            "sine", convert<T>(getsine(o.sinesize, o.sineperiod)));
+    for (const signalspec & spec : o.signals)
+        datasets.emplace_back(spec.name,
+                              convert<T>(generate(spec, o.datasize, datarng())));
+    if (o.cininput)
+        datasets.emplace_back(
+            "input", convert<T>(getcin(o.column, o.parsethreads, std::cerr)));
+    if (datasets.empty()) {
+        std::cerr << "--report expects --white, --walk, --sine, --data or "
+                     "--pipedata"
+                  << std::endl;
+        return -1;
+    }
+    perfcounters counters;
+    if (!counters.anyavailable())
+        std::cerr << "# hardware counters are not available" << std::endl;
+    std::vector<measurement> results;
+    for (const auto & d : datasets) {
+        const std::string & name = d.first;
+        const std::vector<T> & data = d.second;
+        for (int window = o.windowbegin; window < o.windowend; ++window) {
+            const uint width = window;
+            if (width == 0 || width > data.size())
+                continue;
+            std::cerr << "# " << name << " window = " << width << std::endl;
+            if (o.doslow)
+                results.push_back(measurefilter<slowmaxmin<T>>(
+                    "slow", name, data, width, o, counters));
+            results.push_back(measurefilter<vanHerkGilWermanmaxmin<T>>(
+                "vanHerk", name, data, width, o, counters));
+            results.push_back(measurefilter<lemiremaxmin<T>>(
+                "lemire", name, data, width, o, counters));
+            results.push_back(measurefilter<GilKimmel<T>>(
+                "gilkimmel", name, data, width, o, counters));
+            results.push_back(measurefilter<lemirebitmapmaxmin<T>>(
+                "bitmap", name, data, width, o, counters));
+            results.push_back(measurefilter<simplelemiremaxmin<T>>(
+                "simplelemire", name, data, width, o, counters));
+            results.push_back(measurefilter<lemiremaxminwrap<T>>(
+                "lemirew", name, data, width, o, counters));
+            results.push_back(measurefilter<monowedgewrap<T>>(
+                "monowedge", name, data, width, o, counters));
+            results.push_back(measurefilter<vanHerkGilWermanmaxminsimd<T>>(
+                "vanHerksimd", name, data, width, o, counters));
+            results.push_back(measurefilter<adaptivemaxmin<T>>(
+                "adaptive", name, data, width, o, counters));
+            results.push_back(measurestream<lemiremaxmintruestreaming<T>>(
+                "lemirebatch", name, data, width, o.type, o.times, counters));
+            results.push_back(measurestream<lemiremaxminbranchless<T>>(
+                "branchless", name, data, width, o.type, o.times, counters));
+            results.push_back(measurestream<lemiremaxminbounded<T>>(
+                "bounded", name, data, width, o.type, o.times, counters));
+            results.push_back(measurestream<counted<T, true>>(
+                "lemirestats", name, data, width, o.type, o.times, counters));
+            results.push_back(measurestream<counted<T, false>>(
+                "lemirecounts", name, data, width, o.type, o.times, counters));
+        }
+    }
+    std::ofstream file;
+    if (!o.reportfile.empty()) {
+        file.open(o.reportfile);
+        if (!file) {
+            std::cerr << "cannot write " << o.reportfile << std::endl;
+            return -1;
+        }
+    }
+    std::ostream & out = o.reportfile.empty() ? std::cout : file;
+    if (o.report == "csv")
+        writecsv(out, results);
+    else if (o.report == "json")
+        writejson(out, results);
+    else
+        writetext(out, results);
+    return 0;
+}
+
+/**
+ * The streaming filters with and without the branch on the direction of
+ * each step, against van Herk/Gil-Werman, over white noise, a random walk
+ * and a sine wave of o.branches samples: time and branch misses per
+ * element, o.times repetitions each.
+ */
+template <typename T>
+void branchtimings(const benchmarkoptions & o, uint width) {
+    const size_t size = o.branches;
+    const floattype period = o.sineperiod > 0 ? o.sineperiod : 500;
+    const std::pair<const char *, std::vector<T>> datasets[] = {
+        {"white", convert<T>(getwhite(size))},
+        {"walk", convert<T>(getrandomwalk(size))},
+        {"sine", convert<T>(getsine(size, period))}};
+    perfcounters counters;
+    if (!counters.available(1))
+        std::cout << "# branch misses are not available" << std::endl;
+    std::vector<measurement> results;
+    for (const auto & d : datasets) {
+        results.push_back(measurestream<lemiremaxmintruestreaming<T>>(
+            "lemirebatch", d.first, d.second, width, o.type, o.times,
+            counters));
+        results.push_back(measurestream<lemiremaxminbranchless<T>>(
+            "branchless", d.first, d.second, width, o.type, o.times,
+            counters));
+        results.push_back(measurefilter<vanHerkGilWermanmaxmin<T>>(
+            "vanHerk", d.first, d.second, width, o, counters));
+    }
+    writetext(std::cout, results);
+}
+
+// time-stamp counter ticks of each update of a Stream filter fed data
+template <typename Stream, typename T>
+std::vector<double> updatecycles(const std::vector<T> & data, uint width,
+                                 uint & sink) {
+    std::vector<double> cycles(data.size());
+    Stream stream(width);
+    for (size_t i = 0; i < data.size(); ++i) {
+        const uint64_t start = cyclecounter();
+        stream.update(data[i]);
+        cycles[i] = static_cast<double>(cyclecounter() - start);
+        sink ^= stream.max() < stream.min();
+    }
+    return cycles;
+}
+
+/**
+ * The streaming filter against its bounded variant, over white noise and
+ * over falling runs of width - 1 samples each flushed by one high sample
+ * (the worst case of the linear scan): mean and tail of the time-stamp
+ * counter ticks per update, over o.latency samples, counter overhead
+ * included. The maximum also catches interrupts and page faults.
+ */
+template <typename T>
+void latencytimings(const benchmarkoptions & o, uint width) {
+    std::vector<signalspec> specs = {{signalshape::white, 0, "white"}};
+    if (width > 1)
+        specs.push_back({signalshape::wedgeflush, width - 1.0,
+                         "wedgeflush:" + std::to_string(width - 1)});
+    std::vector<std::pair<std::string, std::vector<T>>> datasets;
+    for (const signalspec & spec : specs)
+        datasets.emplace_back(
+            spec.name, convert<T>(generate(spec, o.latency, datarng())));
+    const std::vector<double> qs = {0.5, 0.99, 0.999, 0.9999, 1};
+    uint sink = 0;
+    std::cout << std::left << std::setw(16) << "#algorithm" << std::setw(16)
+              << "dataset" << std::right << std::setw(12) << "mean"
+              << std::setw(12) << "p50" << std::setw(12) << "p99"
+              << std::setw(12) << "p99.9" << std::setw(12) << "p99.99"
+              << std::setw(12) << "max" << std::endl;
+    for (const auto & d : datasets) {
+        const std::pair<const char *, std::vector<double>> runs[] = {
+            {"lemirebatch", updatecycles<lemiremaxmintruestreaming<T>>(
+                                d.second, width, sink)},
+            {"bounded", updatecycles<lemiremaxminbounded<T>>(d.second, width,
+                                                             sink)}};
+        for (const auto & r : runs) {
+            const std::vector<double> q = quantiles(r.second, qs);
+            std::cout << std::left << std::setw(16) << r.first
+                      << std::setw(16) << d.first << std::right
+                      << std::setw(12) << summarize(r.second).mean;
+            for (double v : q)
+                std::cout << std::setw(12) << v;
+            std::cout << (sink ? " " : "") << std::endl;
+        }
+    }
+}
+
+/**
+ * Loads (o.crossovers) or measures and saves (o.calibrate) the engine table
+ * of adaptivemaxmin<T>; the table is printed after calibration.
+ */
+template <typename T>
+int adaptivetable(const benchmarkoptions & o) {
+    typedef adaptivemaxmin<T> adaptive;
+    if (!o.crossovers.empty() && !adaptive::load(o.crossovers)) {
+        std::cerr << "cannot read a table from " << o.crossovers << std::endl;
+        return -1;
+    }
+    if (o.calibrate.empty())
+        return 0;
+    adaptive::calibrate();
+    if (!adaptive::save(o.calibrate)) {
+        std::cerr << "cannot write " << o.calibrate << std::endl;
+        return -1;
+    }
+    std::cerr << "# adaptive engines (rows: widths 1, 2, 3-4, 5-8, ...; "
+                 "columns: mean runs <2, 2-3, 4-7, ...)"
+              << std::endl;
+    for (int w = 0; w < adaptive::widthclasses; ++w) {
+        std::cerr << "#";
+        for (int r = 0; r < adaptive::runclasses; ++r)
+            std::cerr << std::setw(12)
+                      << enginename(
+                             adaptive::table()[w * adaptive::runclasses + r]);
+        std::cerr << std::endl;
+    }
+    return 0;
+}
+
+template <typename T>
+int benchmark(const benchmarkoptions & o) {
+    if (adaptivetable<T>(o) != 0)
+        return -1;
+    if (!o.report.empty())
+        return report<T>(o);
+    const int whitesize = o.whitesize, walksize = o.walksize, times = o.times;
+    const int sinesize = o.sinesize;
+    const floattype sineperiod = o.sineperiod;
+    const bool doslow = o.doslow, cininput = o.cininput;
+    std::vector<T> data(0);
+    std::cout << "# we report timings (in seconds) so lower is better" << std::endl;
+    for (int window = o.windowbegin; window < o.windowend; ++window) {
+        if (o.imagecols > 0) {
+            std::cout << "# window = " << window << "x" << window
+                      << " image = " << o.imagecols << "x" << o.imagerows
+                      << " times = " << times << " (wall-clock seconds)"
+                      << std::endl;
+            assert(window <= o.imagecols && window <= o.imagerows);
+            imagetimings<T>(o.imagecols, o.imagerows, window, times);
+        } else if (o.stride > 0) {
+            std::vector<T> series =
+                walksize > 0 ? convert<T>(getrandomwalk(walksize))
+                             : convert<T>(getwhite(whitesize));
+            std::cout << "# window = " << window << " stride = " << o.stride
+                      << " size = " << series.size() << " times = " << times
+                      << std::endl;
+            assert(static_cast<size_t>(window) <= series.size());
+            stridetimings<T>(series, window, o.stride, times);
+        } else if (o.ranges > 0) {
+            std::vector<T> series =
+                walksize > 0 ? convert<T>(getrandomwalk(walksize))
+                             : convert<T>(getwhite(whitesize));
+            std::cout << "# ranges = " << o.ranges << " of length up to "
+                      << window << " size = " << series.size()
+                      << " times = " << times << std::endl;
+            rangetimings<T>(series, window, o.ranges, times);
+        } else if (!o.bankwidths.empty()) {
+            std::vector<T> series =
+                walksize > 0 ? convert<T>(getrandomwalk(walksize))
+                             : convert<T>(getwhite(whitesize));
+            std::cout << "# widths =";
+            for (uint width : o.bankwidths)
+                std::cout << " " << width;
+            std::cout << " size = " << series.size() << " times = " << times
+                      << std::endl;
+            banktimings<T>(series, o.bankwidths, times);
+            break;
+        } else if (o.threads > 0) {
+            std::vector<T> series =
+                whitesize > 0 ? convert<T>(getwhite(whitesize))
+                : walksize > 0
+                    ? convert<T>(getrandomwalk(walksize))
+                    : convert<T>(getsine(sinesize, sineperiod));
+            std::cout << "# window = " << window << " size = " << series.size()
+                      << " threads = " << o.threads << " times = " << times
+                      << " (wall-clock seconds)" << std::endl;
+            assert(static_cast<size_t>(window) < series.size());
+            threadtimings<T>(series, window, o.threads, times);
+        } else if (o.branches > 0) {
+            std::cout << "# window = " << window << " size = " << o.branches
+                      << " times = " << times << std::endl;
+            assert(window <= o.branches);
+            branchtimings<T>(o, window);
+        } else if (o.latency > 0) {
+            std::cout << "# window = " << window << " size = " << o.latency
+                      << " (time-stamp counter ticks per update)" << std::endl;
+            latencytimings<T>(o, window);
+        } else if (o.lanes > 0) {
+            std::cout << "# window = " << window << " lanes = " << o.lanes
+                      << " ticks = " << whitesize << " times = " << times
+                      << std::endl;
+            assert(whitesize > 0);
+            lanetimings<T>(window, o.lanes, whitesize, times);
+        } else if (!o.signals.empty()) {
+            for (const signalspec & spec : o.signals) {
+                std::vector<T> series =
+                    convert<T>(generate(spec, o.datasize, datarng()));
+                std::cout << "# window = " << window << " data = " << spec.name
+                          << " size = " << o.datasize << " times = " << times
+                          << " doslow = " << doslow << std::endl;
+                assert(static_cast<size_t>(window) <= series.size());
+                process(series, window, times, doslow);
+            }
+        } else if (whitesize > 0) {
+            std::cout << "# window = " << window << " whitesize = " << whitesize
+                      << " times = " << times << " doslow = " << doslow
+                      << std::endl;
+            assert(window + 1 < whitesize);
+            timings<T>(window, whitesize, times, doslow);
+        } else if (walksize > 0) {
+            std::cout << "# window = " << window << " walksize = " << walksize
+                      << " times = " << times << " doslow = " << doslow
+                      << std::endl;
+            walktimings<T>(window, walksize, times, doslow);
+
+        } else if (sinesize > 0) {
+            std::cout << "# window = " << window << " sinesize = " << sinesize
+                      << " sine period " << sineperiod << " times = " << times
+                      << " doslow = " << doslow << std::endl;
+            assert(window + 1 < sinesize);
+            sinetimings<T>(window, sinesize, sineperiod, times, doslow);
+        } else {
+            if ((data.empty()) && cininput) {
+                data = convert<T>(getcin(o.column, o.parsethreads));
+                std::cout << "# window = " << window << " times = " << times
+                          << " doslow = " << doslow << std::endl;
+                process(data, window, times, doslow);
+            } else {
+                std::cout << "Generating sine waves." << std::endl;
+                for (uint width = 3; width <= 100; ++width) {
+                    std::cout << "Using a min/max width of " << width
+                              << std::endl;
+                    sinetimings<T>(width);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * use in conjunction with
+
+ | awk '{print $2}'
+ */
+int main(int params, char ** args) {
+    benchmarkoptions o;
     for (int i = 1; i < params; ++i) {
         if (strcmp(args[i], "--skipslow") == 0) {
-            doslow = false;
+            o.doslow = false;
         }
         if (strcmp(args[i], "--pipedata") == 0) {
-            cininput = true;
+            o.cininput = true;
         }
         if (strcmp(args[i], "--unit") == 0) {
             std::cout << "OK " << std::endl;
@@ -212,8 +1034,8 @@ int main(int params, char ** args) {
         }
         if (strcmp(args[i], "--window") == 0) {
             if (params - i > 1) {
-                windowbegin = atoi(args[++i]);
-                windowend = windowbegin + 1;
+                o.windowbegin = atoi(args[++i]);
+                o.windowend = o.windowbegin + 1;
             } else {
                 std::cerr << "--window expects an integer (length)"
                           << std::endl;
@@ -223,8 +1045,8 @@ int main(int params, char ** args) {
         }
         if (strcmp(args[i], "--windowrange") == 0) {
             if (params - i > 2) {
-                windowbegin = atoi(args[++i]);
-                windowend = atoi(args[++i]) + 1;
+                o.windowbegin = atoi(args[++i]);
+                o.windowend = atoi(args[++i]) + 1;
             } else {
                 std::cerr << "--windowrange expects two integers (length)"
                           << std::endl;
@@ -234,7 +1056,7 @@ int main(int params, char ** args) {
         }
         if (strcmp(args[i], "--white") == 0) {
             if (params - i > 1)
-                whitesize = atoi(args[++i]);
+                o.whitesize = atoi(args[++i]);
             else {
                 std::cerr << "--white expects an integer (length)" << std::endl;
                 return -1;
@@ -243,7 +1065,7 @@ int main(int params, char ** args) {
         }
         if (strcmp(args[i], "--walk") == 0) {
             if (params - i > 1)
-                walksize = atoi(args[++i]);
+                o.walksize = atoi(args[++i]);
             else {
                 std::cerr << "--walk expects an integer (length)" << std::endl;
                 return -1;
@@ -252,24 +1074,257 @@ int main(int params, char ** args) {
         }
         if (strcmp(args[i], "--sine") == 0) {
             if (params - i > 1)
-                sinesize = atoi(args[++i]);
+                o.sinesize = atoi(args[++i]);
             else {
                 std::cerr << "--sine expects an integer (length)" << std::endl;
                 return -1;
             }
             if (params - i > 1)
-                sineperiod = atof(args[++i]);
-            else {
+                o.sineperiod = atof(args[++i]);
+            if (!(o.sineperiod > 0)) {
                 std::cerr << "--sine expects an integer (length) followed by a "
-                             "float (freq) "
+                             "positive float (period)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--data") == 0) {
+            // comma-separated signals, e.g. --data runs:8,runs:64,spikes
+            std::string list = params - i > 1 ? args[++i] : "";
+            for (size_t begin = 0; begin < list.size();) {
+                const size_t end = std::min(list.find(',', begin), list.size());
+                signalspec spec;
+                if (!parsesignal(list.substr(begin, end - begin), spec)) {
+                    std::cerr << "unknown signal "
+                              << list.substr(begin, end - begin)
+                              << " (see generators.h)" << std::endl;
+                    return -1;
+                }
+                o.signals.push_back(spec);
+                begin = end + 1;
+            }
+            if (o.signals.empty()) {
+                std::cerr << "--data expects comma-separated signals"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--size") == 0) {
+            if (params - i > 1)
+                o.datasize = atoi(args[++i]);
+            else {
+                std::cerr << "--size expects an integer (length)" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--seed") == 0) {
+            if (params - i > 1)
+                o.seed = strtoull(args[++i], nullptr, 10);
+            else {
+                std::cerr << "--seed expects an integer" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--column") == 0) {
+            if (params - i > 1)
+                o.column = atoi(args[++i]);
+            else {
+                std::cerr << "--column expects an integer (from 0)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--parsethreads") == 0) {
+            if (params - i > 1)
+                o.parsethreads = std::max(1, atoi(args[++i]));
+            else {
+                std::cerr << "--parsethreads expects an integer" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--input") == 0) {
+            if (params - i > 1)
+                o.input = args[++i];
+            else {
+                std::cerr << "--input expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--format") == 0) {
+            if (params - i > 1)
+                o.format = args[++i];
+            else {
+                std::cerr << "--format expects one of float32, float64, int16"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--maxoutput") == 0) {
+            if (params - i > 1)
+                o.maxoutput = args[++i];
+            else {
+                std::cerr << "--maxoutput expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--minoutput") == 0) {
+            if (params - i > 1)
+                o.minoutput = args[++i];
+            else {
+                std::cerr << "--minoutput expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--type") == 0) {
+            if (params - i > 1)
+                o.type = args[++i];
+            else {
+                std::cerr << "--type expects one of float, double, int8, "
+                             "int16, int32, int64"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--lanes") == 0) {
+            if (params - i > 1)
+                o.lanes = atoi(args[++i]);
+            else {
+                std::cerr << "--lanes expects an integer (number of channels)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--image") == 0) {
+            if (params - i > 2) {
+                o.imagecols = atoi(args[++i]);
+                o.imagerows = atoi(args[++i]);
+            } else {
+                std::cerr << "--image expects two integers (columns rows)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--bank") == 0) {
+            // comma-separated widths, e.g. --bank 10,60,600,3600
+            char * list = params - i > 1 ? args[++i] : nullptr;
+            while (list != nullptr && *list != '\0') {
+                o.bankwidths.push_back(strtoul(list, &list, 10));
+                if (*list == ',')
+                    ++list;
+                else
+                    break;
+            }
+            if (o.bankwidths.empty() ||
+                std::find(o.bankwidths.begin(), o.bankwidths.end(), 0u) !=
+                    o.bankwidths.end()) {
+                std::cerr << "--bank expects comma-separated widths"
                           << std::endl;
                 return -1;
             }
             continue;
         }
+        if (strcmp(args[i], "--stride") == 0) {
+            if (params - i > 1)
+                o.stride = atoi(args[++i]);
+            else {
+                std::cerr << "--stride expects an integer" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--ranges") == 0) {
+            if (params - i > 1)
+                o.ranges = atoi(args[++i]);
+            else {
+                std::cerr << "--ranges expects an integer (queries)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--branches") == 0) {
+            if (params - i > 1)
+                o.branches = atoi(args[++i]);
+            else {
+                std::cerr << "--branches expects an integer (length)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--latency") == 0) {
+            if (params - i > 1)
+                o.latency = atoi(args[++i]);
+            else {
+                std::cerr << "--latency expects an integer (length)"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--threads") == 0) {
+            if (params - i > 1)
+                o.threads = atoi(args[++i]);
+            else {
+                std::cerr << "--threads expects an integer" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--report") == 0) {
+            if (params - i > 1)
+                o.report = args[++i];
+            if (o.report != "text" && o.report != "csv" &&
+                o.report != "json") {
+                std::cerr << "--report expects one of text, csv, json"
+                          << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--calibrate") == 0) {
+            if (params - i > 1)
+                o.calibrate = args[++i];
+            else {
+                std::cerr << "--calibrate expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--crossovers") == 0) {
+            if (params - i > 1)
+                o.crossovers = args[++i];
+            else {
+                std::cerr << "--crossovers expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        if (strcmp(args[i], "--reportfile") == 0) {
+            if (params - i > 1)
+                o.reportfile = args[++i];
+            else {
+                std::cerr << "--reportfile expects a file name" << std::endl;
+                return -1;
+            }
+            continue;
+        }
         if (strcmp(args[i], "--times") == 0) {
             if (params - i > 1)
-                times = atoi(args[++i]);
+                o.times = atoi(args[++i]);
             else {
                 std::cerr << "--times expects an integer" << std::endl;
                 return -1;
@@ -277,41 +1332,46 @@ int main(int params, char ** args) {
             continue;
         }
     }
-    std::cout << "# we report timings (in seconds) so lower is better" << std::endl;
-    for (int window = windowbegin; window < windowend; ++window) {
-        if (whitesize > 0) {
-            std::cout << "# window = " << window << " whitesize = " << whitesize
-                      << " times = " << times << " doslow = " << doslow
+    datarng().reseed(o.seed);
+    if (!o.signals.empty() && o.datasize <= 0) {
+        std::cerr << "--data needs --size" << std::endl;
+        return -1;
+    }
+    if (!o.input.empty()) {
+        if (o.maxoutput.empty() && o.minoutput.empty()) {
+            std::cerr << "--input needs --maxoutput and/or --minoutput"
                       << std::endl;
-            assert(window + 1 < whitesize);
-            timings(window, whitesize, times, doslow);
-        } else if (walksize > 0) {
-            std::cout << "# window = " << window << " walksize = " << walksize
-                      << " times = " << times << " doslow = " << doslow
+            return -1;
+        }
+        if (!littleendianhost()) {
+            std::cerr << "--input reads little-endian values only"
                       << std::endl;
-            walktimings(window, walksize, times, doslow);
-
-        } else if (sinesize > 0) {
-            std::cout << "# window = " << window << " sinesize = " << sinesize
-                      << " sine period " << sineperiod << " times = " << times
-                      << " doslow = " << doslow << std::endl;
-            assert(window + 1 < sinesize);
-            sinetimings(window, sinesize, sineperiod, times, doslow);
-        } else {
-            if ((data.empty()) && cininput) {
-                data = getcin();
-                std::cout << "# window = " << window << " times = " << times
-                          << " doslow = " << doslow << std::endl;
-                process(data, window, times, doslow);
-            } else {
-                std::cout << "Generating sine waves." << std::endl;
-                for (uint width = 3; width <= 100; ++width) {
-                    std::cout << "Using a min/max width of " << width
-                              << std::endl;
-                    sinetimings(width);
-                }
-            }
+            return -1;
         }
+        if (o.format == "float32")
+            return mapped<float>(o);
+        if (o.format == "float64")
+            return mapped<double>(o);
+        if (o.format == "int16")
+            return mapped<int16_t>(o);
+        std::cerr << "unknown --format " << o.format << std::endl;
+        return -1;
     }
-    return 0;
+    (o.report.empty() ? std::cout : std::cerr)
+        << "# type = " << o.type << std::endl
+        << "# isa = " << isaname(hostisa()) << std::endl;
+    if (o.type == "float")
+        return benchmark<float>(o);
+    if (o.type == "double")
+        return benchmark<double>(o);
+    if (o.type == "int8")
+        return benchmark<int8_t>(o);
+    if (o.type == "int16")
+        return benchmark<int16_t>(o);
+    if (o.type == "int32")
+        return benchmark<int32_t>(o);
+    if (o.type == "int64")
+        return benchmark<int64_t>(o);
+    std::cerr << "unknown --type " << o.type << std::endl;
+    return -1;
 }
@@ -18,621 +18,1555 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <vector>
 
 #include "common.h"
+#include "cpuisa.h"
 #include "deque.h"
+#include "filterstats.h"
 
-inline void display(const std::vector<floattype> & a) {
-    for (floattype i : a)
-        std::cout << i << " ";
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * All filters are templates over the element type T and over a strict weak
+ * ordering Compare (std::less<T> by default). The "max" of a window is its
+ * greatest element with respect to Compare and the "min" is its least one,
+ * so passing std::greater<T> swaps the two outputs.
+ *
+ * Each filter class computes its result at construction, into vectors it
+ * owns. The same algorithm is available as a static function,
+ *
+ *   Filter::filter(array, n, width, maxvalues, minvalues[, workspace])
+ *
+ * which reads array[0, n) and writes n - width + 1 values into the caller's
+ * maxvalues and minvalues. Given a filterworkspace, the van Herk, Gil-Kimmel,
+ * bitmap, naive and lemiremaxminwrap filters allocate nothing on the heap.
+ */
+
+template <typename T>
+inline void display(const std::vector<T> & a) {
+    for (T i : a)
+        std::cout << +i << " ";
     std::cout << std::endl;
 }
 
+template <typename T = floattype>
 class minmaxfilter {
 public:
-    virtual std::vector<floattype> & getmaxvalues() = 0;
-    virtual std::vector<floattype> & getminvalues() = 0;
+    virtual std::vector<T> & getmaxvalues() = 0;
+    virtual std::vector<T> & getminvalues() = 0;
 
     virtual ~minmaxfilter() = default;
 };
 
+/**
+ * Reusable scratch memory for the static filter functions. Buffers only
+ * grow, so once a workspace has served a call of a given size, later calls
+ * of that size or smaller perform no heap allocation. A workspace must not
+ * be shared by concurrent calls.
+ */
+template <typename T = floattype>
+class filterworkspace {
+public:
+    // k-th value buffer (k < 2), at least count elements long
+    T * values(uint k, size_t count) {
+        if (valuebuffers[k].size() < count)
+            valuebuffers[k].resize(count);
+        return valuebuffers[k].data();
+    }
+    // k-th queue node buffer (k < 2), at least count nodes long
+    intfloatnode<T> * nodes(uint k, size_t count) {
+        if (nodebuffers[k].size() < count)
+            nodebuffers[k].resize(count);
+        return nodebuffers[k].data();
+    }
+
+private:
+    std::vector<T> valuebuffers[2];
+    std::vector<intfloatnode<T>> nodebuffers[2];
+};
+
+/**
+ * Strided output: only the windows starting at 0, stride, 2 * stride, ...
+ * are reported, stridedsize(n, width, stride) of them.
+ */
+inline size_t stridedsize(size_t n, uint width, uint stride) {
+    return (n - width) / stride + 1;
+}
+
+// strided filter by direct reduction of each reported window, which reads
+// every sample at most once when stride >= width
+template <typename T, typename Compare, minmaxsides Sides>
+void stridedreduce(const T * array, size_t n, uint width, uint stride,
+                   T * maxvalues, T * minvalues, Compare comp) {
+    for (size_t s = 0, k = 0; s + width <= n; s += stride, ++k) {
+        T maxvalue = array[s], minvalue = array[s];
+        for (size_t i = s + 1; i < s + width; ++i) {
+            if (hasmax(Sides))
+                maxvalue = std::max(maxvalue, array[i], comp);
+            if (hasmin(Sides))
+                minvalue = std::min(minvalue, array[i], comp);
+        }
+        if (hasmax(Sides))
+            maxvalues[k] = maxvalue;
+        if (hasmin(Sides))
+            minvalues[k] = minvalue;
+    }
+}
+
 /**
  * This is the naive algorithm one might try first.
  */
-class slowmaxmin : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class slowmaxmin : public minmaxfilter<T> {
 public:
-    slowmaxmin(std::vector<floattype> & array, int width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        floattype maxvalue, minvalue;
-        for (uint s = 0; s < array.size() - width + 1; ++s) {
+    slowmaxmin(std::vector<T> & array, int width, Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> &,
+                       Compare comp = Compare()) {
+        filter(array, n, width, maxvalues, minvalues, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        T maxvalue, minvalue;
+        for (uint s = 0; s < n - width + 1; ++s) {
             maxvalue = array[s];
             minvalue = array[s];
             // could be done with iterators
             for (uint k = s + 1; k < s + width; ++k) {
-                if (maxvalue < array[k])
+                if (hasmax(Sides) && comp(maxvalue, array[k]))
                     maxvalue = array[k];
-                if (minvalue > array[k])
+                if (hasmin(Sides) && comp(array[k], minvalue))
                     minvalue = array[k];
             }
-            maxvalues[s] = maxvalue;
-            minvalues[s] = minvalue;
+            if (hasmax(Sides))
+                maxvalues[s] = maxvalue;
+            if (hasmin(Sides))
+                minvalues[s] = minvalue;
         }
     }
-    std::vector<floattype> & getmaxvalues() {
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
 /**
  * This is an implementation of the patented Gil-Kimmel algorithm.
  * Could be rewritten to use less memory.
  */
-class GilKimmel : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class GilKimmel : public minmaxfilter<T> {
 public:
-    GilKimmel(std::vector<floattype> & array, int width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        std::vector<floattype> R(array.size() + 1);
-        std::vector<floattype> S(array.size() + 1);
-        computePrefixSuffixMax(R, S, array,
-                               width); // implements the cut in the middle trick
-        for (int j = 0; j < static_cast<int>(array.size()) - width + 1;
-             j += width) {
-            const int endofblock =
-                std::min(j + width, static_cast<int>(array.size()) - width + 1);
-            int begin = j;
-            int end = endofblock;
-            int midpoint = (end - begin + 1) / 2 + begin;
-            while (midpoint != end) {
-                if (S[midpoint + width - 1] <= R[midpoint]) {
-                    begin = midpoint;
-                    midpoint = (end - begin + 1) / 2 + begin;
-                } else {
-                    end = midpoint;
-                    midpoint = (end - begin + 1) / 2 + begin;
+    GilKimmel(std::vector<T> & array, int width, Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filter(array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> & ws,
+                       Compare comp = Compare()) {
+        if (width == 1) { // the cut in the middle needs two elements
+            if (hasmax(Sides))
+                std::copy(array, array + n, maxvalues);
+            if (hasmin(Sides))
+                std::copy(array, array + n, minvalues);
+            return;
+        }
+        T * const R = ws.values(0, n + 1);
+        T * const S = ws.values(1, n + 1);
+        if (hasmax(Sides)) {
+            // implements the cut in the middle trick
+            computePrefixSuffixMax(R, S, array, n, width, comp);
+            for (int j = 0; j < static_cast<int>(n) - width + 1; j += width) {
+                const int endofblock =
+                    std::min(j + width, static_cast<int>(n) - width + 1);
+                int begin = j;
+                int end = endofblock;
+                int midpoint = (end - begin + 1) / 2 + begin;
+                while (midpoint != end) {
+                    if (!comp(R[midpoint], S[midpoint + width - 1])) {
+                        begin = midpoint;
+                        midpoint = (end - begin + 1) / 2 + begin;
+                    } else {
+                        end = midpoint;
+                        midpoint = (end - begin + 1) / 2 + begin;
+                    }
+                }
+                for (int jj = j; jj < midpoint; ++jj) {
+                    maxvalues[jj] = R[jj];
+                }
+                for (int jj = midpoint; jj < endofblock; ++jj) {
+                    maxvalues[jj] = S[jj + width - 1];
                 }
-            }
-            for (int jj = j; jj < midpoint; ++jj) {
-                maxvalues[jj] = R[jj];
-            }
-            for (int jj = midpoint; jj < endofblock; ++jj) {
-                maxvalues[jj] = S[jj + width - 1];
             }
         }
-        computePrefixSuffixMin(R, S, array,
-                               width); // implements the cut in the middle trick
-        for (int j = 0; j < static_cast<int>(array.size()) - width + 1;
-             j += width) {
-            const int endofblock =
-                std::min(j + width, static_cast<int>(array.size()) - width + 1);
-            int begin = j;
-            int end = endofblock;
-            int midpoint = (end - begin + 1) / 2 + begin;
-            while (midpoint != end) {
-                if (S[midpoint + width - 1] >= R[midpoint]) {
-                    begin = midpoint;
-                    midpoint = (end - begin + 1) / 2 + begin;
-                } else {
-                    end = midpoint;
-                    midpoint = (end - begin + 1) / 2 + begin;
+        if (hasmin(Sides)) {
+            // implements the cut in the middle trick
+            computePrefixSuffixMin(R, S, array, n, width, comp);
+            for (int j = 0; j < static_cast<int>(n) - width + 1; j += width) {
+                const int endofblock =
+                    std::min(j + width, static_cast<int>(n) - width + 1);
+                int begin = j;
+                int end = endofblock;
+                int midpoint = (end - begin + 1) / 2 + begin;
+                while (midpoint != end) {
+                    if (!comp(S[midpoint + width - 1], R[midpoint])) {
+                        begin = midpoint;
+                        midpoint = (end - begin + 1) / 2 + begin;
+                    } else {
+                        end = midpoint;
+                        midpoint = (end - begin + 1) / 2 + begin;
+                    }
+                }
+                for (int jj = j; jj < midpoint; ++jj) {
+                    minvalues[jj] = R[jj];
+                }
+                for (int jj = midpoint; jj < endofblock; ++jj) {
+                    minvalues[jj] = S[jj + width - 1];
                 }
             }
-            for (int jj = j; jj < midpoint; ++jj) {
-                minvalues[jj] = R[jj];
-            }
-            for (int jj = midpoint; jj < endofblock; ++jj) {
-                minvalues[jj] = S[jj + width - 1];
-            }
         }
     }
-    void computePrefixSuffixMax(std::vector<floattype> & R,
-                                std::vector<floattype> & S,
-                                const std::vector<floattype> & array,
-                                const int width) {
-        for (int j = 0; j < static_cast<int>(array.size()); j += width) {
+    /**
+     * Strided version of filter: only the windows starting at multiples of
+     * stride, into maxvalues and minvalues[0, stridedsize(n, width, stride)).
+     * The prefix and suffix passes are the same as those of filter; only
+     * the reported windows are merged, which also skips the binary search
+     * for the cut. With stride >= width, each reported window is reduced
+     * directly.
+     */
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filterstrided(array, n, width, stride, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              filterworkspace<T> & ws,
+                              Compare comp = Compare()) {
+        if (stride >= width) {
+            stridedreduce<T, Compare, Sides>(array, n, width, stride, maxvalues,
+                                             minvalues, comp);
+            return;
+        }
+        T * const R = ws.values(0, n + 1);
+        T * const S = ws.values(1, n + 1);
+        // R and S hold the true suffix (prefix) extrema wherever the cut
+        // does not matter, so each window is the better of its two ends
+        if (hasmax(Sides)) {
+            computePrefixSuffixMax(R, S, array, n, width, comp);
+            for (size_t s = 0, k = 0; s + width <= n; s += stride, ++k)
+                maxvalues[k] = std::max(R[s], S[s + width - 1], comp);
+        }
+        if (hasmin(Sides)) {
+            computePrefixSuffixMin(R, S, array, n, width, comp);
+            for (size_t s = 0, k = 0; s + width <= n; s += stride, ++k)
+                minvalues[k] = std::min(R[s], S[s + width - 1], comp);
+        }
+    }
+    static void computePrefixSuffixMax(T * R, T * S, const T * array, size_t n,
+                                       const int width, Compare comp) {
+        for (int j = 0; j < static_cast<int>(n); j += width) {
             const int begin = j;
-            const int end = std::min(static_cast<int>(array.size()), j + width);
+            const int end = std::min(static_cast<int>(n), j + width);
             const int midpoint = (end - begin + 1) / 2 + begin;
             S[begin] = array[begin];
             for (int jj = begin + 1; jj < midpoint; ++jj) {
-                S[jj] = std::max(array[jj], S[jj - 1]);
+                S[jj] = std::max(array[jj], S[jj - 1], comp);
             }
             R[end - 1] = array[end - 1];
             for (int jj = end - 2; jj >= midpoint; --jj) {
-                R[jj] = std::max(R[jj + 1], array[jj]);
+                R[jj] = std::max(R[jj + 1], array[jj], comp);
             }
-            if (std::max(R[midpoint], S[midpoint - 1]) == R[midpoint]) {
+            if (!comp(R[midpoint], S[midpoint - 1])) {
                 for (int jj = midpoint; jj < end; ++jj)
-                    S[jj] = std::max(array[jj], S[jj - 1]);
+                    S[jj] = std::max(array[jj], S[jj - 1], comp);
                 for (int jj = midpoint - 1; jj >= begin; --jj)
                     R[jj] = R[midpoint];
             } else {
                 for (int jj = midpoint - 1; jj >= begin; --jj)
-                    R[jj] = std::max(R[jj + 1], array[jj]);
+                    R[jj] = std::max(R[jj + 1], array[jj], comp);
                 for (int jj = midpoint; jj < end; ++jj)
                     S[jj] = S[midpoint - 1];
             }
         }
     }
 
-    void computePrefixSuffixMin(std::vector<floattype> & R,
-                                std::vector<floattype> & S,
-                                const std::vector<floattype> & array,
-                                const int width) {
-        for (int j = 0; j < static_cast<int>(array.size()); j += width) {
+    static void computePrefixSuffixMin(T * R, T * S, const T * array, size_t n,
+                                       const int width, Compare comp) {
+        for (int j = 0; j < static_cast<int>(n); j += width) {
             const int begin = j;
-            const int end = std::min(static_cast<int>(array.size()), j + width);
+            const int end = std::min(static_cast<int>(n), j + width);
             const int midpoint = (end - begin + 1) / 2 + begin;
             S[begin] = array[begin];
             for (int jj = begin + 1; jj < midpoint; ++jj) {
-                S[jj] = std::min(array[jj], S[jj - 1]);
+                S[jj] = std::min(array[jj], S[jj - 1], comp);
             }
             R[end - 1] = array[end - 1];
             for (int jj = end - 2; jj >= midpoint; --jj) {
-                R[jj] = std::min(R[jj + 1], array[jj]);
+                R[jj] = std::min(R[jj + 1], array[jj], comp);
             }
-            if (std::min(R[midpoint], S[midpoint - 1]) == R[midpoint]) {
+            if (!comp(S[midpoint - 1], R[midpoint])) {
                 for (int jj = midpoint; jj < end; ++jj)
-                    S[jj] = std::min(array[jj], S[jj - 1]);
+                    S[jj] = std::min(array[jj], S[jj - 1], comp);
                 for (int jj = midpoint - 1; jj >= begin; --jj)
                     R[jj] = R[midpoint];
             } else {
                 for (int jj = midpoint - 1; jj >= begin; --jj)
-                    R[jj] = std::min(R[jj + 1], array[jj]);
+                    R[jj] = std::min(R[jj + 1], array[jj], comp);
                 for (int jj = midpoint; jj < end; ++jj)
                     S[jj] = S[midpoint - 1];
             }
         }
     }
-    std::vector<floattype> & getmaxvalues() {
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
 /**
  * This should be very close to the van Herk algorithm.
  */
-class vanHerkGilWermanmaxmin : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class vanHerkGilWermanmaxmin : public minmaxfilter<T> {
 public:
-    vanHerkGilWermanmaxmin(std::vector<floattype> & array, int width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        std::vector<floattype> R(width);
-        std::vector<floattype> S(width);
-        for (uint j = 0; j < array.size() - width + 1; j += width) {
-            uint Rpos = std::min(j + width - 1,
-                                 static_cast<unsigned>(array.size() - 1));
-            R[0] = array[Rpos];
-            for (uint i = Rpos - 1; i + 1 > j; i -= 1)
-                R[Rpos - i] = std::max(R[Rpos - i - 1], array[i]);
-            S[0] = array[Rpos];
-            uint m1 = std::min(j + 2 * width - 1,
-                               static_cast<unsigned>(array.size()));
-            for (uint i = Rpos + 1; i < m1; ++i) {
-                S[i - Rpos] = std::max(S[i - Rpos - 1], array[i]);
+    vanHerkGilWermanmaxmin(std::vector<T> & array, int width,
+                           Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filter(array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> & ws,
+                       Compare comp = Compare()) {
+        T * const R = ws.values(0, width);
+        T * const S = ws.values(1, width);
+        if (hasmax(Sides)) {
+            for (uint j = 0; j < n - width + 1; j += width) {
+                uint Rpos = std::min(j + width - 1, static_cast<unsigned>(n - 1));
+                R[0] = array[Rpos];
+                for (uint i = Rpos - 1; i + 1 > j; i -= 1)
+                    R[Rpos - i] = std::max(R[Rpos - i - 1], array[i], comp);
+                S[0] = array[Rpos];
+                uint m1 = std::min(j + 2 * width - 1, static_cast<unsigned>(n));
+                for (uint i = Rpos + 1; i < m1; ++i) {
+                    S[i - Rpos] = std::max(S[i - Rpos - 1], array[i], comp);
+                }
+                for (uint i = 0; i < m1 - Rpos; i += 1)
+                    maxvalues[j + i] =
+                        std::max(S[i], R[(Rpos - j + 1) - i - 1], comp);
             }
-            for (uint i = 0; i < m1 - Rpos; i += 1)
-                maxvalues[j + i] = std::max(S[i], R[(Rpos - j + 1) - i - 1]);
         }
-        for (uint j = 0; j < array.size() - width + 1; j += width) {
-            uint Rpos = std::min(j + width - 1,
-                                 static_cast<unsigned>(array.size() - 1));
+        if (hasmin(Sides)) {
+            for (uint j = 0; j < n - width + 1; j += width) {
+                uint Rpos = std::min(j + width - 1, static_cast<unsigned>(n - 1));
+                R[0] = array[Rpos];
+                for (uint i = Rpos - 1; i + 1 > j; i -= 1)
+                    R[Rpos - i] = std::min(R[Rpos - i - 1], array[i], comp);
+                S[0] = array[Rpos];
+                uint m1 = std::min(j + 2 * width - 1, static_cast<unsigned>(n));
+                for (uint i = Rpos + 1; i < m1; ++i) {
+                    S[i - Rpos] = std::min(S[i - Rpos - 1], array[i], comp);
+                }
+                for (uint i = 0; i < m1 - Rpos; i += 1)
+                    minvalues[j + i] =
+                        std::min(S[i], R[(Rpos - j + 1) - i - 1], comp);
+            }
+        }
+    }
+
+    /**
+     * Strided version of filter: only the windows starting at multiples of
+     * stride, into maxvalues and minvalues[0, stridedsize(n, width, stride)).
+     * Within each block, the suffix pass stops at the first reported start,
+     * the prefix pass at the last one, and only reported windows are merged.
+     * With stride >= width, each reported window is reduced directly.
+     */
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filterstrided(array, n, width, stride, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              filterworkspace<T> & ws,
+                              Compare comp = Compare()) {
+        if (stride >= width) {
+            stridedreduce<T, Compare, Sides>(array, n, width, stride, maxvalues,
+                                             minvalues, comp);
+            return;
+        }
+        T * const R = ws.values(0, width);
+        T * const S = ws.values(1, width);
+        if (hasmax(Sides))
+            strided<true>(array, n, width, stride, maxvalues, R, S, comp);
+        if (hasmin(Sides))
+            strided<false>(array, n, width, stride, minvalues, R, S, comp);
+    }
+    // one side of filterstrided, for stride < width
+    template <bool ismax>
+    static void strided(const T * array, size_t n, uint width, uint stride,
+                        T * out, T * R, T * S, Compare comp) {
+        const auto best = [comp](const T & a, const T & b) {
+            return ismax ? std::max(a, b, comp) : std::min(a, b, comp);
+        };
+        for (size_t j = 0; j + width <= n; j += width) {
+            const size_t Rpos = j + width - 1;
+            const size_t m1 = std::min<size_t>(j + 2 * width - 1, n);
+            // the reported windows start at j + i, i = first, ..., last
+            const size_t first = (stride - j % stride) % stride;
+            if (first >= m1 - Rpos)
+                continue;
+            const size_t last =
+                first + (m1 - Rpos - 1 - first) / stride * stride;
             R[0] = array[Rpos];
-            for (uint i = Rpos - 1; i + 1 > j; i -= 1)
-                R[Rpos - i] = std::min(R[Rpos - i - 1], array[i]);
+            for (size_t i = Rpos; i-- > j + first;)
+                R[Rpos - i] = best(R[Rpos - i - 1], array[i]);
             S[0] = array[Rpos];
-            uint m1 = std::min(j + 2 * width - 1,
-                               static_cast<unsigned>(array.size()));
-            for (uint i = Rpos + 1; i < m1; ++i) {
-                S[i - Rpos] = std::min(S[i - Rpos - 1], array[i]);
+            for (size_t i = Rpos + 1; i <= Rpos + last; ++i)
+                S[i - Rpos] = best(S[i - Rpos - 1], array[i]);
+            for (size_t i = first; i <= last; i += stride)
+                out[(j + i) / stride] = best(S[i], R[width - 1 - i]);
+        }
+    }
+
+    /**
+     * filter that also writes the positions of the extrema into argmax and
+     * argmin[0, n - width + 1); any of the four outputs may be null. Of equal
+     * extrema, the last is reported with argties::last, else the first. R
+     * and S hold positions rather than values.
+     */
+    template <argties Ties = argties::first>
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, uint * argmax, uint * argmin,
+                       Compare comp = Compare()) {
+        std::vector<uint> R(width), S(width);
+        if (hasmax(Sides) && (maxvalues != nullptr || argmax != nullptr))
+            argside<Ties, true>(array, n, width, maxvalues, argmax, R.data(),
+                                S.data(), comp);
+        if (hasmin(Sides) && (minvalues != nullptr || argmin != nullptr))
+            argside<Ties, false>(array, n, width, minvalues, argmin, R.data(),
+                                 S.data(), comp);
+    }
+    // one side of the filter with positions
+    template <argties Ties, bool ismax>
+    static void argside(const T * array, size_t n, uint width, T * values,
+                        uint * positions, uint * R, uint * S, Compare comp) {
+        // of positions p < q, the one reported
+        const auto best = [array, comp](uint p, uint q) {
+            const T & x = array[p];
+            const T & y = array[q];
+            const bool later = Ties == argties::last
+                                   ? !(ismax ? comp(y, x) : comp(x, y))
+                                   : (ismax ? comp(x, y) : comp(y, x));
+            return later ? q : p;
+        };
+        for (uint j = 0; j + width <= n; j += width) {
+            const uint Rpos = j + width - 1;
+            const uint m1 = std::min(j + 2 * width - 1, static_cast<uint>(n));
+            // R[k] covers [Rpos - k, Rpos], S[k] covers [Rpos, Rpos + k]
+            R[0] = Rpos;
+            for (uint i = Rpos; i-- > j;)
+                R[Rpos - i] = best(i, R[Rpos - i - 1]);
+            S[0] = Rpos;
+            for (uint i = Rpos + 1; i < m1; ++i)
+                S[i - Rpos] = best(S[i - Rpos - 1], i);
+            for (uint i = 0; i < m1 - Rpos; ++i) {
+                const uint p = best(R[width - 1 - i], S[i]);
+                if (values != nullptr)
+                    values[j + i] = array[p];
+                if (positions != nullptr)
+                    positions[j + i] = p;
             }
-            for (uint i = 0; i < m1 - Rpos; i += 1)
-                minvalues[j + i] = std::min(S[i], R[(Rpos - j + 1) - i - 1]);
         }
-        assert(maxvalues.size() == array.size() - width + 1);
-        assert(minvalues.size() == array.size() - width + 1);
     }
-    std::vector<floattype> & getmaxvalues() {
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
+// sizes a wedge for windows of width samples: the ring buffer is allocated
+// once, std::deque grows on its own
+template <typename V>
+void reservewedge(std::deque<V> &, uint) {}
+template <typename V>
+void reservewedge(ringqueue<V> & wedge, uint width) {
+    wedge.reserve(width + 1);
+}
+
 /**
  * implementation of the streaming algorithm
+ *
+ * Fifo holds the wedges: ringqueue<int> (the default) or std::deque<int>.
  */
-class lemiremaxmin : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both,
+          typename Fifo = ringqueue<int>>
+class lemiremaxmin : public minmaxfilter<T> {
 public:
-    lemiremaxmin(std::vector<floattype> & array, uint width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        std::deque<int> maxfifo, minfifo;
+    lemiremaxmin(std::vector<T> & array, uint width, Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> &,
+                       Compare comp = Compare()) {
+        filter(array, n, width, maxvalues, minvalues, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        Fifo maxfifo, minfifo;
+        if (hasmax(Sides))
+            reservewedge(maxfifo, width);
+        if (hasmin(Sides))
+            reservewedge(minfifo, width);
         for (uint i = 1; i < width; ++i) {
-            if (array[i] > array[i - 1]) { // overshoot
-                minfifo.push_back(i - 1);
-                while (!maxfifo.empty()) {
-                    if (array[i] <= array[maxfifo.back()]) {
-                        if (i == width + maxfifo.front())
-                            maxfifo.pop_front();
-                        break;
-                    }
-                    maxfifo.pop_back();
-                }
+            if (comp(array[i - 1], array[i])) { // overshoot
+                if (hasmin(Sides))
+                    minfifo.push_back(i - 1);
+                if (hasmax(Sides))
+                    prune(array, maxfifo, i, width, comp, true);
             } else {
-                maxfifo.push_back(i - 1);
-                while (!minfifo.empty()) {
-                    if (array[i] >= array[minfifo.back()]) {
-                        if (i == width + minfifo.front())
-                            minfifo.pop_front();
-                        break;
-                    }
-                    minfifo.pop_back();
-                }
+                if (hasmax(Sides))
+                    maxfifo.push_back(i - 1);
+                if (hasmin(Sides))
+                    prune(array, minfifo, i, width, comp, false);
             }
         }
-        for (uint i = width; i < array.size(); ++i) {
-            maxvalues[i - width] =
-                array[maxfifo.empty() ? i - 1 : maxfifo.front()];
-            minvalues[i - width] =
-                array[minfifo.empty() ? i - 1 : minfifo.front()];
-            if (array[i] > array[i - 1]) { // overshoot
-                minfifo.push_back(i - 1);
-                if (i == width + minfifo.front())
-                    minfifo.pop_front();
-                while (!maxfifo.empty()) {
-                    if (array[i] <= array[maxfifo.back()]) {
-                        if (i == width + maxfifo.front())
-                            maxfifo.pop_front();
-                        break;
-                    }
-                    maxfifo.pop_back();
+        for (uint i = width; i < n; ++i) {
+            if (hasmax(Sides))
+                maxvalues[i - width] =
+                    array[maxfifo.empty() ? i - 1 : maxfifo.front()];
+            if (hasmin(Sides))
+                minvalues[i - width] =
+                    array[minfifo.empty() ? i - 1 : minfifo.front()];
+            if (comp(array[i - 1], array[i])) { // overshoot
+                if (hasmin(Sides)) {
+                    minfifo.push_back(i - 1);
+                    if (i == width + minfifo.front())
+                        minfifo.pop_front();
                 }
+                if (hasmax(Sides))
+                    prune(array, maxfifo, i, width, comp, true);
             } else {
-                maxfifo.push_back(i - 1);
-                if (i == width + maxfifo.front())
-                    maxfifo.pop_front();
-                while (!minfifo.empty()) {
-                    if (array[i] >= array[minfifo.back()]) {
-                        if (i == width + minfifo.front())
-                            minfifo.pop_front();
-                        break;
-                    }
-                    minfifo.pop_back();
+                if (hasmax(Sides)) {
+                    maxfifo.push_back(i - 1);
+                    if (i == width + maxfifo.front())
+                        maxfifo.pop_front();
                 }
+                if (hasmin(Sides))
+                    prune(array, minfifo, i, width, comp, false);
             }
         }
-        maxvalues[array.size() - width] =
-            array[maxfifo.empty() ? array.size() - 1 : maxfifo.front()];
-        minvalues[array.size() - width] =
-            array[minfifo.empty() ? array.size() - 1 : minfifo.front()];
+        if (hasmax(Sides))
+            maxvalues[n - width] =
+                array[maxfifo.empty() ? n - 1 : maxfifo.front()];
+        if (hasmin(Sides))
+            minvalues[n - width] =
+                array[minfifo.empty() ? n - 1 : minfifo.front()];
+    }
+    // pops from the back of fifo the indices that array[i] dominates
+    static void prune(const T * array, Fifo & fifo, uint i,
+                      uint width, Compare comp, bool ismax) {
+        while (!fifo.empty()) {
+            if (ismax ? !comp(array[fifo.back()], array[i])
+                      : !comp(array[i], array[fifo.back()])) {
+                if (i == width + fifo.front())
+                    fifo.pop_front();
+                break;
+            }
+            fifo.pop_back();
+        }
+    }
+
+    /**
+     * filter that also writes the positions of the extrema into argmax and
+     * argmin[0, n - width + 1); any of the four outputs may be null. Of equal
+     * extrema, the last is reported with argties::last, else the first: a
+     * sample prunes the equal ones before it only with argties::last.
+     */
+    template <argties Ties = argties::first>
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, uint * argmax, uint * argmin,
+                       Compare comp = Compare()) {
+        const bool domax =
+            hasmax(Sides) && (maxvalues != nullptr || argmax != nullptr);
+        const bool domin =
+            hasmin(Sides) && (minvalues != nullptr || argmin != nullptr);
+        Fifo maxfifo, minfifo;
+        if (domax)
+            reservewedge(maxfifo, width);
+        if (domin)
+            reservewedge(minfifo, width);
+        for (uint i = 1; i < n; ++i) {
+            if (i >= width) {
+                if (domax)
+                    argreport(array, maxfifo, i - 1, maxvalues, argmax,
+                              i - width);
+                if (domin)
+                    argreport(array, minfifo, i - 1, minvalues, argmin,
+                              i - width);
+            }
+            if (domax)
+                argprune<Ties, true>(array, maxfifo, i, width, comp);
+            if (domin)
+                argprune<Ties, false>(array, minfifo, i, width, comp);
+        }
+        const uint last = static_cast<uint>(n - 1);
+        if (domax)
+            argreport(array, maxfifo, last, maxvalues, argmax, n - width);
+        if (domin)
+            argreport(array, minfifo, last, minvalues, argmin, n - width);
+    }
+    // whether array[i] takes the place of the earlier array[j]
+    template <argties Ties, bool ismax>
+    static bool argdominates(const T * array, uint i, uint j, Compare comp) {
+        const T & x = array[j];
+        const T & y = array[i];
+        return Ties == argties::last ? !(ismax ? comp(y, x) : comp(x, y))
+                                     : (ismax ? comp(x, y) : comp(y, x));
     }
-    std::vector<floattype> & getmaxvalues() {
+    // i - 1 joins fifo unless array[i] dominates it, in which case array[i]
+    // pops the indices it dominates
+    template <argties Ties, bool ismax>
+    static void argprune(const T * array, Fifo & fifo, uint i, uint width,
+                         Compare comp) {
+        if (!argdominates<Ties, ismax>(array, i, i - 1, comp)) {
+            fifo.push_back(i - 1);
+            if (i == width + fifo.front())
+                fifo.pop_front();
+            return;
+        }
+        while (!fifo.empty()) {
+            if (!argdominates<Ties, ismax>(array, i, fifo.back(), comp)) {
+                if (i == width + fifo.front())
+                    fifo.pop_front();
+                return;
+            }
+            fifo.pop_back();
+        }
+    }
+    // the extremum of the window ending at last, which fifo leaves implicit
+    static void argreport(const T * array, Fifo & fifo, uint last, T * values,
+                          uint * positions, size_t k) {
+        const uint p = fifo.empty() ? last : static_cast<uint>(fifo.front());
+        if (values != nullptr)
+            values[k] = array[p];
+        if (positions != nullptr)
+            positions[k] = p;
+    }
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
-// actual streaming implementation
+/**
+ * actual streaming implementation
+ *
+ * argmax() and argmin() give the position of the extremum in the stream
+ * (the number of samples seen before it); with Ties set to first or last,
+ * equal samples are resolved accordingly at the cost of one extra
+ * comparison on non-increasing samples.
+ *
+ * Queue is intfloatqueue<T> (the default) or compactqueue<T>, which takes
+ * less memory per entry but limits the width to 65535 samples. Either way,
+ * the sample counter n may wrap past 2^32: the window stays right, argmax()
+ * and argmin() are then positions modulo 2^32.
+ *
+ * Stats is nostats (the default), which costs nothing, or filterstats<>,
+ * which counts the queue depths, pops, comparisons and ticks of every
+ * update in stats (see filterstats.h).
+ */
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both, argties Ties = argties::any,
+          typename Queue = intfloatqueue<T>, typename Stats = nostats>
 class lemiremaxmintruestreaming {
 public:
-    explicit lemiremaxmintruestreaming(uint width)
-        : up(), lo(), n(0), ww(width) {
-        init(&up, ww);
-        init(&lo, ww);
+    explicit lemiremaxmintruestreaming(uint width, Compare c = Compare())
+        : up(), lo(), n(0), ww(width), owned(true), comp(c) {
+        assert(ww <= maxage(&up));
+        if (hasmax(Sides))
+            init(&up, ww);
+        if (hasmin(Sides))
+            init(&lo, ww);
+    }
+
+    // runs over the nodes of a workspace instead of allocating its queues
+    // (intfloatqueue only)
+    lemiremaxmintruestreaming(uint width, filterworkspace<T> & ws,
+                              Compare c = Compare())
+        : up(), lo(), n(0), ww(width), owned(false), comp(c) {
+        if (hasmax(Sides))
+            init(&up, ws.nodes(0, nodecount(ww)), ww);
+        if (hasmin(Sides))
+            init(&lo, ws.nodes(1, nodecount(ww)), ww);
     }
 
     ~lemiremaxmintruestreaming() {
-        free(&up);
-        free(&lo);
+        if (owned && hasmax(Sides))
+            free(&up);
+        if (owned && hasmin(Sides))
+            free(&lo);
+    }
+
+    lemiremaxmintruestreaming(const lemiremaxmintruestreaming &) = delete;
+    lemiremaxmintruestreaming &
+    operator=(const lemiremaxmintruestreaming &) = delete;
+
+    void update(T value) {
+        insert(&up, &lo, n, value);
+        n++;
     }
 
-    void update(floattype value) {
-        if (nonempty(&up) != 0) {
-            if (value > tailvalue(&up)) {
-                prunetail(&up);
-                while (((nonempty(&up)) != 0) && (value >= tailvalue(&up))) {
-                    prunetail(&up);
+    /**
+     * Same as calling update(in[i]) and then storing max() and min() into
+     * out_max[i] and out_min[i], for i in [0, count). The queues are kept in
+     * locals for the whole block and the state carries over from one call to
+     * the next, so a stream may be fed in blocks of any size.
+     */
+    void update_batch(const T * in, size_t count, T * out_max, T * out_min) {
+        Queue u = up, l = lo;
+        uint index = n;
+        for (size_t i = 0; i < count; ++i, ++index) {
+            insert(&u, &l, index, in[i]);
+            if (hasmax(Sides))
+                out_max[i] = headvalue(&u);
+            if (hasmin(Sides))
+                out_min[i] = headvalue(&l);
+        }
+        up = u;
+        lo = l;
+        n = index;
+    }
+
+    T max() {
+        return headvalue(&up);
+    }
+    T min() {
+        return headvalue(&lo);
+    }
+    uint argmax() {
+        return n - 1 - headage(&up, n - 1);
+    }
+    uint argmin() {
+        return n - 1 - headage(&lo, n - 1);
+    }
+
+private:
+    // true if the queued sample t can never again be the max (min) once
+    // value arrives; equal samples are dropped unless the first one wins
+    bool maxdominated(T t, T value) const {
+        return Ties == argties::first ? comp(t, value) : !comp(value, t);
+    }
+    bool mindominated(T t, T value) const {
+        return Ties == argties::first ? comp(value, t) : !comp(t, value);
+    }
+
+    // appends sample number index to the queues u and l; the counts are
+    // dead code unless Stats records them
+    void insert(Queue * u, Queue * l, uint index, T value) {
+        const uint64_t start = stats.start();
+        uint pops = 0, evictions = 0, comparisons = 0;
+        if (nonempty(hasmax(Sides) ? u : l) != 0) {
+            // with a single side, the other side's queue does not exist and
+            // its tail is implied by the previous sample
+            const T previous = hasmax(Sides) ? tailvalue(u) : tailvalue(l);
+            comparisons++;
+            if (comp(previous, value)) {
+                if (hasmax(Sides)) {
+                    uint dominated = 0;
+                    prunetail(u);
+                    while (((nonempty(u)) != 0) &&
+                           maxdominated(tailvalue(u), value)) {
+                        prunetail(u);
+                        dominated++;
+                    }
+                    comparisons += dominated + (nonempty(u) != 0);
+                    pops += dominated + 1;
                 }
             } else {
-                prunetail(&lo);
-                while (((nonempty(&lo)) != 0) && (value <= tailvalue(&lo))) {
-                    prunetail(&lo);
+                const bool equal =
+                    (Ties != argties::any) && !comp(value, previous);
+                comparisons += Ties != argties::any;
+                if ((Ties == argties::last) && hasmax(Sides) && equal) {
+                    prunetail(u); // the newer of two equal samples wins
+                    pops++;
+                }
+                if (hasmin(Sides) && !((Ties == argties::first) && equal)) {
+                    uint dominated = 0;
+                    prunetail(l);
+                    while (((nonempty(l)) != 0) &&
+                           mindominated(tailvalue(l), value)) {
+                        prunetail(l);
+                        dominated++;
+                    }
+                    comparisons += dominated + (nonempty(l) != 0);
+                    pops += dominated + 1;
                 }
             }
         }
-        push(&up, n, value);
-        if (n == ww + headindex(&up)) {
-            prunehead(&up);
+        if (hasmax(Sides)) {
+            push(u, index, value);
+            if (headage(u, index) == ww) {
+                prunehead(u);
+                evictions++;
+            }
         }
-
-        push(&lo, n, value);
-        if (n == ww + headindex(&lo)) {
-            prunehead(&lo);
+        if (hasmin(Sides)) {
+            push(l, index, value);
+            if (headage(l, index) == ww) {
+                prunehead(l);
+                evictions++;
+            }
         }
+        stats.record(start, hasmax(Sides) ? count(u) : 0,
+                     hasmin(Sides) ? count(l) : 0, pops, evictions,
+                     comparisons);
+    }
+
+public:
+    Queue up;
+    Queue lo;
+    uint n;
+    uint ww;
+    bool owned;
+    Compare comp;
+    Stats stats;
+};
+
+/**
+ * Streaming filter with the interface and the outputs (argmax() and
+ * argmin() included) of lemiremaxmintruestreaming with argties::any, for
+ * inputs such as noise where the branch of the latter on the direction of
+ * each step mispredicts about half the time.
+ *
+ * Here the queue to prune is picked with masks: the head, tail and nodes of
+ * up and lo are blended arithmetically, the previous sample is dropped from
+ * the tail of the chosen queue and the tail is stored back the same way.
+ * Only the loop over further dominated entries branches. The previous
+ * sample is kept in a register instead of being read back from the queues,
+ * which keeps memory off the path from one update to the next.
+ *
+ * Whether this pays depends on the branch predictor: the direction of white
+ * noise is partly predictable (a rise is followed by a fall two times out of
+ * three) and the pruning loop still mispredicts, so the branchy filter can
+ * stay ahead; runningmaxmin --branches compares them.
+ */
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class lemiremaxminbranchless {
+public:
+    typedef intfloatqueue<T> Queue;
+
+    explicit lemiremaxminbranchless(uint width, Compare c = Compare())
+        : up(), lo(), n(0), ww(width), last(), comp(c) {
+        if (hasmax(Sides))
+            init(&up, ww);
+        if (hasmin(Sides))
+            init(&lo, ww);
+    }
+
+    ~lemiremaxminbranchless() {
+        if (hasmax(Sides))
+            free(&up);
+        if (hasmin(Sides))
+            free(&lo);
+    }
+
+    lemiremaxminbranchless(const lemiremaxminbranchless &) = delete;
+    lemiremaxminbranchless &
+    operator=(const lemiremaxminbranchless &) = delete;
+
+    void update(T value) {
+        insert(&up, &lo, n, value, last);
         n++;
     }
 
-    floattype max() {
+    // as lemiremaxmintruestreaming::update_batch
+    void update_batch(const T * in, size_t count, T * out_max, T * out_min) {
+        Queue u = up, l = lo;
+        uint index = n;
+        T previous = last;
+        for (size_t i = 0; i < count; ++i, ++index) {
+            insert(&u, &l, index, in[i], previous);
+            if (hasmax(Sides))
+                out_max[i] = headvalue(&u);
+            if (hasmin(Sides))
+                out_min[i] = headvalue(&l);
+        }
+        up = u;
+        lo = l;
+        n = index;
+        last = previous;
+    }
+
+    T max() {
         return headvalue(&up);
     }
-    floattype min() {
+    T min() {
         return headvalue(&lo);
     }
+    uint argmax() {
+        return n - 1 - headage(&up, n - 1);
+    }
+    uint argmin() {
+        return n - 1 - headage(&lo, n - 1);
+    }
+
+private:
+    // appends sample number index to the queues u and l; previous is the
+    // sample before it, and becomes value
+    void insert(Queue * u, Queue * l, uint index, T value,
+                T & previous) const {
+        if (nonempty(hasmax(Sides) ? u : l) != 0) {
+            // all ones to prune up, zero to prune lo; with a single side,
+            // previous is only dropped if value moves past it
+            const uint rising = static_cast<uint>(comp(previous, value));
+            const uint side = hasmax(Sides) && hasmin(Sides) ? 0u - rising
+                              : hasmax(Sides)                ? ~0u
+                                                             : 0u;
+            const uint mask = hasmax(Sides) ? u->mask : l->mask;
+            const uint head = pick(side, u->head, l->head);
+            const intfloatnode<T> * nodes =
+                reinterpret_cast<const intfloatnode<T> *>(
+                    pick(side, reinterpret_cast<uintptr_t>(u->nodes),
+                         reinterpret_cast<uintptr_t>(l->nodes)));
+            const uint drop = hasmax(Sides) && hasmin(Sides) ? 1
+                              : hasmax(Sides)                ? rising
+                                                             : 1 - rising;
+            uint tail = (pick(side, u->tail, l->tail) - drop) & mask;
+            while ((drop != 0) && (tail != head) &&
+                   (dominated(side, nodes[(tail - 1) & mask].value, value) !=
+                    0))
+                tail = (tail - 1) & mask;
+            if (hasmax(Sides))
+                u->tail = pick(side, tail, u->tail);
+            if (hasmin(Sides))
+                l->tail = pick(side, l->tail, tail);
+        }
+        if (hasmax(Sides)) {
+            push(u, index, value);
+            if (headage(u, index) == ww)
+                prunehead(u);
+        }
+        if (hasmin(Sides)) {
+            push(l, index, value);
+            if (headage(l, index) == ww)
+                prunehead(l);
+        }
+        previous = value;
+    }
+
+    // a where side is all ones, b where it is zero
+    template <typename V>
+    static V pick(uint side, V a, V b) {
+        return b ^ ((a ^ b) & static_cast<V>(static_cast<int>(side)));
+    }
 
-    intfloatqueue up;
-    intfloatqueue lo;
+    // 1 if the queued sample t can never again be the max (the min, for a
+    // zero side) once value arrives, else 0
+    uint dominated(uint side, T t, T value) const {
+        return pick(side, static_cast<uint>(!comp(value, t)),
+                    static_cast<uint>(!comp(t, value)));
+    }
+
+public:
+    Queue up;
+    Queue lo;
     uint n;
     uint ww;
+    T last; // the latest sample, at the tail of both queues
+    Compare comp;
 };
 
 // wrapper over the streaming version
-class lemiremaxminwrap : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class lemiremaxminwrap : public minmaxfilter<T> {
 public:
-    lemiremaxminwrap(std::vector<floattype> & array, uint width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        lemiremaxmintruestreaming lts(width);
+    lemiremaxminwrap(std::vector<T> & array, uint width,
+                     Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filter(array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> & ws,
+                       Compare comp = Compare()) {
+        lemiremaxmintruestreaming<T, Compare, Sides> lts(width, ws, comp);
         for (uint i = 0; i < width - 1; ++i) {
             lts.update(array[i]);
         }
-        for (uint i = width - 1; i < array.size(); ++i) {
+        for (uint i = width - 1; i < n; ++i) {
             lts.update(array[i]);
-            maxvalues[i - width + 1] = lts.max();
-            minvalues[i - width + 1] = lts.min();
+            if (hasmax(Sides))
+                maxvalues[i - width + 1] = lts.max();
+            if (hasmin(Sides))
+                minvalues[i - width + 1] = lts.min();
         }
     }
-    std::vector<floattype> & getmaxvalues() {
+
+    /**
+     * Strided version of filter: only the windows starting at multiples of
+     * stride, into maxvalues and minvalues[0, stridedsize(n, width, stride)).
+     * With stride >= width, samples between reported windows are skipped.
+     */
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filterstrided(array, n, width, stride, maxvalues, minvalues, ws, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              filterworkspace<T> & ws,
+                              Compare comp = Compare()) {
+        if (stride >= width) {
+            stridedreduce<T, Compare, Sides>(array, n, width, stride, maxvalues,
+                                             minvalues, comp);
+            return;
+        }
+        lemiremaxmintruestreaming<T, Compare, Sides> lts(width, ws, comp);
+        for (uint i = 0; i < width - 1; ++i) {
+            lts.update(array[i]);
+        }
+        uint skip = 0; // samples until the next reported window
+        for (uint i = width - 1, k = 0; i < n; ++i) {
+            lts.update(array[i]);
+            if (skip-- != 0)
+                continue;
+            skip = stride - 1;
+            if (hasmax(Sides))
+                maxvalues[k] = lts.max();
+            if (hasmin(Sides))
+                minvalues[k] = lts.min();
+            ++k;
+        }
+    }
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
 #include "mono_wedge.h"
 
+template <typename T = floattype>
 struct Sample {
-	floattype value;
+	T      value;
 	uint   time;
+};
 
-	bool operator<(const Sample &o) const    {return value < o.value;}
-	bool operator>(const Sample &o) const    {return value > o.value;}
+// orders samples by value, through the filter's comparator
+template <typename T, typename Compare, bool greater>
+struct SampleCompare {
+	Compare comp;
+	bool operator()(const Sample<T> &a, const Sample<T> &b) const {
+		return greater ? comp(b.value, a.value) : comp(a.value, b.value);
+	}
 };
-// wrapper over the monowedge streaming version
-class monowedgewrap : public minmaxfilter {
+
+// wrapper over the monowedge streaming version; Wedge is
+// ringqueue<Sample<T>> (the default) or std::deque<Sample<T>>
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both,
+          typename Wedge = ringqueue<Sample<T>>>
+class monowedgewrap : public minmaxfilter<T> {
 public:
-    monowedgewrap(std::vector<floattype> & array, uint width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        std::deque<Sample> max_wedge;
-        std::deque<Sample> min_wedge;
+    monowedgewrap(std::vector<T> & array, uint width, Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> &,
+                       Compare comp = Compare()) {
+        filter(array, n, width, maxvalues, minvalues, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        Wedge max_wedge;
+        Wedge min_wedge;
+        if (hasmax(Sides))
+            reservewedge(max_wedge, width);
+        if (hasmin(Sides))
+            reservewedge(min_wedge, width);
+        SampleCompare<T, Compare, true> maxcomp = {comp};
+        SampleCompare<T, Compare, false> mincomp = {comp};
         for (uint i = 0; i < width - 1; ++i) {
-            Sample sample = {array[i], i};
-            mono_wedge::max_wedge_update(max_wedge, sample);
-            mono_wedge::min_wedge_update(min_wedge, sample);
+            Sample<T> sample = {array[i], i};
+            if (hasmax(Sides))
+                mono_wedge::mono_wedge_update(max_wedge, sample, maxcomp);
+            if (hasmin(Sides))
+                mono_wedge::mono_wedge_update(min_wedge, sample, mincomp);
         }
-        for (uint i = width; i < array.size(); ++i) {
-            Sample sample = {array[i], i};
-            mono_wedge::max_wedge_update(max_wedge, sample);
-            mono_wedge::min_wedge_update(min_wedge, sample);
-            while (max_wedge.front().time <= i-width) max_wedge.pop_front();
-            while (min_wedge.front().time <= i-width) min_wedge.pop_front();
-            maxvalues[i - width + 1] = max_wedge.front().value;
-            minvalues[i - width + 1] = min_wedge.front().value;
+        for (uint i = width - 1; i < n; ++i) {
+            Sample<T> sample = {array[i], i};
+            if (hasmax(Sides)) {
+                mono_wedge::mono_wedge_update(max_wedge, sample, maxcomp);
+                while (max_wedge.front().time + width <= i) max_wedge.pop_front();
+                maxvalues[i - width + 1] = max_wedge.front().value;
+            }
+            if (hasmin(Sides)) {
+                mono_wedge::mono_wedge_update(min_wedge, sample, mincomp);
+                while (min_wedge.front().time + width <= i) min_wedge.pop_front();
+                minvalues[i - width + 1] = min_wedge.front().value;
+            }
         }
     }
-    std::vector<floattype> & getmaxvalues() {
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
+/**
+ * Streaming filter with a worst-case bound on each update: O(log width)
+ * comparisons, where lemiremaxmintruestreaming may pop a whole window of
+ * samples at once (after a long monotone run, say) and is only amortized
+ * O(1).
+ *
+ * The wedges are ringqueue<Sample<T>> and are pruned with
+ * mono_wedge_update: Fenn's search probes the last log2(size) entries from
+ * the tail and bisects the rest, then the dominated suffix goes in one
+ * move of the tail. Expiry pops at most one head entry per update.
+ *
+ * Same outputs as lemiremaxmintruestreaming with argties::last: of equal
+ * samples, argmax() and argmin() give the newest.
+ */
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class lemiremaxminbounded {
+public:
+    explicit lemiremaxminbounded(uint width, Compare c = Compare())
+        : n(0), ww(width), maxcomp{c}, mincomp{c} {
+        if (hasmax(Sides))
+            reservewedge(up, ww);
+        if (hasmin(Sides))
+            reservewedge(lo, ww);
+    }
+
+    lemiremaxminbounded(const lemiremaxminbounded &) = delete;
+    lemiremaxminbounded & operator=(const lemiremaxminbounded &) = delete;
+
+    void update(T value) {
+        const Sample<T> sample = {value, n};
+        if (hasmax(Sides)) {
+            mono_wedge::mono_wedge_update(up, sample, maxcomp);
+            if (n - up.front().time == ww)
+                up.pop_front();
+        }
+        if (hasmin(Sides)) {
+            mono_wedge::mono_wedge_update(lo, sample, mincomp);
+            if (n - lo.front().time == ww)
+                lo.pop_front();
+        }
+        n++;
+    }
+
+    // as lemiremaxmintruestreaming::update_batch
+    void update_batch(const T * in, size_t count, T * out_max, T * out_min) {
+        for (size_t i = 0; i < count; ++i) {
+            update(in[i]);
+            if (hasmax(Sides))
+                out_max[i] = up.front().value;
+            if (hasmin(Sides))
+                out_min[i] = lo.front().value;
+        }
+    }
+
+    T max() {
+        return up.front().value;
+    }
+    T min() {
+        return lo.front().value;
+    }
+    uint argmax() {
+        return up.front().time;
+    }
+    uint argmin() {
+        return lo.front().time;
+    }
+
+    ringqueue<Sample<T>> up;
+    ringqueue<Sample<T>> lo;
+    uint n;
+    uint ww;
+
+private:
+    SampleCompare<T, Compare, true> maxcomp;
+    SampleCompare<T, Compare, false> mincomp;
+};
+
+// index of the lowest (highest) set bit of x, which must not be zero
+inline int lowestbit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long r;
+    _BitScanForward64(&r, x);
+    return static_cast<int>(r);
+#else
+    int r = 0;
+    for (int half = 32; half > 0; half >>= 1)
+        if ((x & ((uint64_t(1) << half) - 1)) == 0) {
+            x >>= half;
+            r += half;
+        }
+    return r;
+#endif
+}
+inline int highestbit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long r;
+    _BitScanReverse64(&r, x);
+    return static_cast<int>(r);
+#else
+    int r = 0;
+    for (int half = 32; half > 0; half >>= 1)
+        if ((x >> half) != 0) {
+            x >>= half;
+            r += half;
+        }
+    return r;
+#endif
+}
+
+/**
+ * Bitset of 64 * Words bits for the bitmap filter, on the stack; Words = 0
+ * takes the number of words at run time.
+ */
+template <size_t Words>
+struct bitwindow {
+    explicit bitwindow(uint) : w() {}
+    uint words() const {
+        return Words;
+    }
+    uint64_t w[Words];
+};
+template <>
+struct bitwindow<0> {
+    explicit bitwindow(uint words) : w(words) {}
+    uint words() const {
+        return static_cast<uint>(w.size());
+    }
+    std::vector<uint64_t> w;
+};
 
 /**
  * implementation of the bitmap-based streaming algorithm
+ *
+ * Bit b of a bitmap stands for the sample b steps before the current one,
+ * and is set while that sample is in the max (min) wedge; the current
+ * sample itself is always in both. Windows up to 64 samples use one
+ * machine word, wider ones 2, 4 or 8 words on the stack, then a heap
+ * bitset: shifting and scanning cost one operation per word.
  */
-class lemirebitmapmaxmin : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class lemirebitmapmaxmin : public minmaxfilter<T> {
 public:
-    // TODO: make the code portable to non-GCC-like compilers
-    // TODO: extend beyond 64-bit to include 128-bit
-    lemirebitmapmaxmin(std::vector<floattype> & array, const uint width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        assert(width <= sizeof(unsigned long) * 8);
-        unsigned long maxfifo = 0;
-        unsigned long minfifo = 0;
+    lemirebitmapmaxmin(std::vector<T> & array, const uint width,
+                       Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> &,
+                       Compare comp = Compare()) {
+        filter(array, n, width, maxvalues, minvalues, comp);
+    }
+    static void filter(const T * array, size_t n, const uint width,
+                       T * maxvalues, T * minvalues, Compare comp = Compare()) {
+        switch ((width + 63) / 64) {
+        case 1:
+            return run<1>(array, n, width, maxvalues, minvalues, comp);
+        case 2:
+            return run<2>(array, n, width, maxvalues, minvalues, comp);
+        case 3:
+            return run<3>(array, n, width, maxvalues, minvalues, comp);
+        case 4:
+            return run<4>(array, n, width, maxvalues, minvalues, comp);
+        case 5:
+        case 6:
+            return run<6>(array, n, width, maxvalues, minvalues, comp);
+        case 7:
+        case 8:
+            return run<8>(array, n, width, maxvalues, minvalues, comp);
+        default:
+            return run<0>(array, n, width, maxvalues, minvalues, comp);
+        }
+    }
+    std::vector<T> & getmaxvalues() {
+        return maxvalues;
+    }
+    std::vector<T> & getminvalues() {
+        return minvalues;
+    }
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
+
+private:
+    template <size_t Words>
+    MAXMIN_MULTIVERSION
+    static void run(const T * array, size_t n, const uint width,
+                    T * maxvalues, T * minvalues, Compare comp) {
+        const uint words = (width + 63) / 64;
+        // bits of the top word that are in the window
+        const uint64_t mask =
+            width % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (width % 64)) - 1;
+        bitwindow<Words> maxfifo(words);
+        bitwindow<Words> minfifo(words);
         for (uint i = 1; i < width; ++i) {
-            if (array[i] > array[i - 1]) { // overshoot
-                minfifo |= 1;
-                minfifo <<= 1;
-                maxfifo <<= 1;
-                while (maxfifo != 0) {
-                    const long t = maxfifo & -maxfifo;
-                    const int bitpos = __builtin_popcountl(t - 1);
-                    if (array[i] <= array[i - bitpos]) {
-                        break;
-                    }
-                    maxfifo ^= t;
-                }
-            } else {
-                maxfifo |= 1;
-                minfifo <<= 1;
-                maxfifo <<= 1;
-                while (minfifo != 0) {
-                    const long t = minfifo & -minfifo;
-                    const int bitpos = __builtin_popcountl(t - 1);
-                    if (array[i] >= array[i - bitpos]) {
-                        break;
-                    }
-                    minfifo ^= t;
-                }
-            }
+            step(array, i, maxfifo, minfifo, comp);
+        }
+        for (uint i = width; i < n; ++i) {
+            if (hasmax(Sides))
+                maxvalues[i - width] = oldest(array, i, words, mask, maxfifo);
+            if (hasmin(Sides))
+                minvalues[i - width] = oldest(array, i, words, mask, minfifo);
+            step(array, i, maxfifo, minfifo, comp);
         }
-        unsigned long mask = ~0l;
-        if (width < sizeof(unsigned long) * 8) {
-            mask = (1UL << width) - 1;
-        }
-        for (uint i = width; i < array.size(); ++i) {
-            maxfifo &= mask;
-            minfifo &= mask;
-            if (maxfifo == 0)
-                maxvalues[i - width] = array[i - 1];
-            else {
-                maxvalues[i - width] = array[i - (sizeof(unsigned long) * 8 -
-                                                  __builtin_clzl(maxfifo))];
+        if (hasmax(Sides))
+            maxvalues[n - width] = oldest(array, n, words, mask, maxfifo);
+        if (hasmin(Sides))
+            minvalues[n - width] = oldest(array, n, words, mask, minfifo);
+    }
+
+    // moves from sample i - 1 to sample i
+    template <typename Bits>
+    static void step(const T * array, uint i, Bits & maxfifo, Bits & minfifo,
+                     Compare comp) {
+        if (comp(array[i - 1], array[i])) { // overshoot
+            if (hasmin(Sides))
+                shift(minfifo, 1);
+            if (hasmax(Sides)) {
+                shift(maxfifo, 0);
+                prune(array, i, maxfifo, comp, true);
             }
-            if (minfifo == 0)
-                minvalues[i - width] = array[i - 1];
-            else {
-                minvalues[i - width] = array[i - (sizeof(unsigned long) * 8 -
-                                                  __builtin_clzl(minfifo))];
+        } else {
+            if (hasmax(Sides))
+                shift(maxfifo, 1);
+            if (hasmin(Sides)) {
+                shift(minfifo, 0);
+                prune(array, i, minfifo, comp, false);
             }
-            if (array[i] > array[i - 1]) { // overshoot
-                minfifo |= 1;
-                minfifo <<= 1;
-                maxfifo <<= 1;
-                while (maxfifo != 0) {
-                    const long t = maxfifo & -maxfifo;
-                    const int bitpos = __builtin_popcountl(t - 1);
-                    if (array[i] <= array[i - bitpos]) {
-                        break;
-                    }
-                    maxfifo ^= t;
-                }
-            } else {
-                maxfifo |= 1;
-                maxfifo <<= 1;
-                minfifo <<= 1;
-                while (minfifo != 0) {
-                    const long t = minfifo & -minfifo;
-                    const int bitpos = __builtin_popcountl(t - 1);
-                    if (array[i] >= array[i - bitpos]) {
-                        break;
-                    }
-                    minfifo ^= t;
-                }
+        }
+    }
+
+    // ages every bit by one step, bit 1 taking the value of in
+    template <typename Bits>
+    static void shift(Bits & fifo, uint64_t in) {
+        for (uint k = fifo.words() - 1; k > 0; --k)
+            fifo.w[k] = (fifo.w[k] << 1) | (fifo.w[k - 1] >> 63);
+        fifo.w[0] = (fifo.w[0] | in) << 1;
+    }
+
+    // clears the youngest samples that sample i dominates
+    template <typename Bits>
+    static void prune(const T * array, uint i, Bits & fifo, Compare comp,
+                      bool ismax) {
+        for (uint k = 0; k < fifo.words(); ++k) {
+            while (fifo.w[k] != 0) {
+                const uint bitpos = k * 64 + lowestbit(fifo.w[k]);
+                if (ismax ? !comp(array[i - bitpos], array[i])
+                          : !comp(array[i], array[i - bitpos]))
+                    return;
+                fifo.w[k] &= fifo.w[k] - 1;
             }
         }
-        maxfifo = maxfifo & mask;
-        minfifo = minfifo & mask;
-        if (maxfifo == 0)
-            maxvalues[array.size() - width] = array[array.size() - 1];
-        else
-            maxvalues[array.size() - width] =
-                array[array.size() -
-                      (sizeof(unsigned long) * 8 - __builtin_clzl(maxfifo))];
-        if (minfifo == 0)
-            minvalues[array.size() - width] = array[array.size() - 1];
-        else
-            minvalues[array.size() - width] =
-                array[array.size() -
-                      (sizeof(unsigned long) * 8 - __builtin_clzl(minfifo))];
-    }
-    std::vector<floattype> & getmaxvalues() {
-        return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
-        return minvalues;
+
+    // drops the samples older than the window [i - width, i - 1], which
+    // spans 'words' words, then returns its max (min): the oldest sample
+    // left, or else sample i - 1
+    template <typename Bits>
+    static T oldest(const T * array, size_t i, uint words, uint64_t mask,
+                    Bits & fifo) {
+        const uint top = words - 1;
+        fifo.w[top] &= mask;
+        for (uint k = fifo.words() - 1; k > top; --k)
+            fifo.w[k] = 0;
+        for (uint k = top + 1; k-- > 0;)
+            if (fifo.w[k] != 0)
+                return array[i - 1 - (k * 64 + highestbit(fifo.w[k]))];
+        return array[i - 1];
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
 };
 
 /**
  * simplest implementation (pseudocode-like)
+ *
+ * Fifo holds the wedges: ringqueue<int> (the default) or std::deque<int>.
  */
-class simplelemiremaxmin : public minmaxfilter {
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both,
+          typename Fifo = ringqueue<int>>
+class simplelemiremaxmin : public minmaxfilter<T> {
 public:
-    simplelemiremaxmin(std::vector<floattype> & array, uint width)
-        : maxvalues(array.size() - width + 1),
-          minvalues(array.size() - width + 1) {
-        std::deque<int> maxfifo, minfifo;
-        maxfifo.push_back(0);
-        minfifo.push_back(0);
+    simplelemiremaxmin(std::vector<T> & array, uint width,
+                       Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> &,
+                       Compare comp = Compare()) {
+        filter(array, n, width, maxvalues, minvalues, comp);
+    }
+    MAXMIN_MULTIVERSION
+    static void filter(const T * array, size_t n, uint width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        Fifo maxfifo, minfifo;
+        if (hasmax(Sides)) {
+            reservewedge(maxfifo, width);
+            maxfifo.push_back(0);
+        }
+        if (hasmin(Sides)) {
+            reservewedge(minfifo, width);
+            minfifo.push_back(0);
+        }
         for (uint i = 1; i < width; ++i) {
-            if (array[i] > array[i - 1]) { // overshoot
-                maxfifo.pop_back();
-                while (!maxfifo.empty()) {
-                    if (array[i] <= array[maxfifo.back()])
-                        break;
-                    maxfifo.pop_back();
-                }
-            } else {
-                minfifo.pop_back();
-                while (!minfifo.empty()) {
-                    if (array[i] >= array[minfifo.back()])
-                        break;
-                    minfifo.pop_back();
-                }
-            }
-            maxfifo.push_back(i);
-            minfifo.push_back(i);
+            step(array, maxfifo, minfifo, i, comp);
         }
-        for (uint i = width; i < array.size(); ++i) {
-            maxvalues[i - width] = array[maxfifo.front()];
-            minvalues[i - width] = array[minfifo.front()];
-            if (array[i] > array[i - 1]) { // overshoot
+        for (uint i = width; i < n; ++i) {
+            if (hasmax(Sides))
+                maxvalues[i - width] = array[maxfifo.front()];
+            if (hasmin(Sides))
+                minvalues[i - width] = array[minfifo.front()];
+            step(array, maxfifo, minfifo, i, comp);
+            if (hasmax(Sides) && (i == width + maxfifo.front()))
+                maxfifo.pop_front();
+            else if (hasmin(Sides) && (i == width + minfifo.front()))
+                minfifo.pop_front();
+        }
+        if (hasmax(Sides))
+            maxvalues[n - width] = array[maxfifo.front()];
+        if (hasmin(Sides))
+            minvalues[n - width] = array[minfifo.front()];
+    }
+    // appends sample i, pruning the side it dominates
+    static void step(const T * array, Fifo & maxfifo, Fifo & minfifo, uint i,
+                     Compare comp) {
+        if (comp(array[i - 1], array[i])) { // overshoot
+            if (hasmax(Sides)) {
                 maxfifo.pop_back();
                 while (!maxfifo.empty()) {
-                    if (array[i] <= array[maxfifo.back()])
+                    if (!comp(array[maxfifo.back()], array[i]))
                         break;
                     maxfifo.pop_back();
                 }
-            } else {
+            }
+        } else if (hasmin(Sides)) {
+            minfifo.pop_back();
+            while (!minfifo.empty()) {
+                if (!comp(array[i], array[minfifo.back()]))
+                    break;
                 minfifo.pop_back();
-                while (!minfifo.empty()) {
-                    if (array[i] >= array[minfifo.back()])
-                        break;
-                    minfifo.pop_back();
-                }
             }
+        }
+        if (hasmax(Sides))
             maxfifo.push_back(i);
+        if (hasmin(Sides))
             minfifo.push_back(i);
-            if (i == width + maxfifo.front())
-                maxfifo.pop_front();
-            else if (i == width + minfifo.front())
-                minfifo.pop_front();
-        }
-        maxvalues[array.size() - width] = array[maxfifo.front()];
-        minvalues[array.size() - width] = array[minfifo.front()];
     }
-    std::vector<floattype> & getmaxvalues() {
+    std::vector<T> & getmaxvalues() {
         return maxvalues;
     }
-    std::vector<floattype> & getminvalues() {
+    std::vector<T> & getminvalues() {
         return minvalues;
     }
-    std::vector<floattype> maxvalues;
-    std::vector<floattype> minvalues;
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
 };
 
 #endif
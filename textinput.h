@@ -0,0 +1,138 @@
+/**
+ * Fast parsing of numeric text: one value per line, or one column of
+ * delimited text (CSV and the like).
+ *
+ * The input is read whole, in large blocks, and numbers are parsed in place
+ * with std::from_chars (std::strtod before C++17), straight into the target
+ * type: no stream extraction and no intermediate float. Fields are separated
+ * by one ',', ';' or tab, or by runs of spaces; spaces around fields and a
+ * trailing '\r' are ignored. Lines whose selected field is missing or not a
+ * number (headers, blank lines) are skipped.
+ *
+ * With several threads, the text is cut at line boundaries into one chunk
+ * per thread; the values come out in input order either way.
+ */
+
+#ifndef TEXTINPUT_H
+#define TEXTINPUT_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+#include "common.h"
+
+// reads all of file in large blocks, plus a final '\0' (not part of the text)
+inline std::vector<char> readall(std::FILE * file) {
+    std::vector<char> buffer(size_t(1) << 20);
+    size_t size = 0;
+    while (true) {
+        size += std::fread(buffer.data() + size, 1, buffer.size() - size, file);
+        if (size < buffer.size())
+            break;
+        buffer.resize(2 * buffer.size());
+    }
+    buffer.resize(size + 1);
+    buffer[size] = '\0';
+    return buffer;
+}
+
+inline bool isdelimiter(char c) {
+    return c == ',' || c == ';' || c == '\t';
+}
+
+// parses the number at p, before end; returns the position after it, or
+// nullptr if there is none
+template <typename T>
+const char * parsenumber(const char * p, const char * end, T & value) {
+    if (p < end && *p == '+')
+        ++p;
+#if defined(__cpp_lib_to_chars)
+    const std::from_chars_result r = std::from_chars(p, end, value);
+    return r.ec == std::errc() ? r.ptr : nullptr;
+#else
+    // the text is followed by a delimiter, a newline or the final '\0'
+    char * after;
+    value = static_cast<T>(std::strtod(p, &after));
+    return after == p || after > end ? nullptr : after;
+#endif
+}
+
+/**
+ * Appends to values the number in field 'column' (from 0) of each line of
+ * [begin, end).
+ */
+template <typename T>
+void parsecolumn(const char * begin, const char * end, uint column,
+                 std::vector<T> & values) {
+    for (const char * line = begin; line < end;) {
+        const char * eol =
+            static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (eol == nullptr)
+            eol = end;
+        const char * p = line;
+        for (uint field = 0;; ++field) {
+            while (p < eol && *p == ' ')
+                ++p;
+            if (field == column) {
+                T value;
+                const char * after = parsenumber(p, eol, value);
+                // the number must fill the field
+                if (after != nullptr &&
+                    (after == eol || *after == ' ' || isdelimiter(*after) ||
+                     *after == '\r'))
+                    values.push_back(value);
+                break;
+            }
+            while (p < eol && *p != ' ' && !isdelimiter(*p))
+                ++p;
+            while (p < eol && *p == ' ')
+                ++p;
+            if (p == eol)
+                break;
+            if (isdelimiter(*p))
+                ++p;
+        }
+        line = eol + 1;
+    }
+}
+
+// parsecolumn over [begin, end) with up to 'threads' threads
+template <typename T>
+std::vector<T> parsecolumn(const char * begin, const char * end, uint column,
+                           uint threads) {
+    const size_t size = end - begin;
+    // at least 1 MB per thread
+    const size_t chunks =
+        std::max<size_t>(1, std::min<size_t>(threads, size >> 20));
+    std::vector<const char *> cuts(chunks + 1, end);
+    cuts[0] = begin;
+    for (size_t t = 1; t < chunks; ++t) {
+        const char * cut = std::max(cuts[t - 1], begin + size * t / chunks);
+        const char * eol =
+            static_cast<const char *>(std::memchr(cut, '\n', end - cut));
+        cuts[t] = eol == nullptr ? end : eol + 1;
+    }
+    std::vector<std::vector<T>> parts(chunks);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < chunks; ++t)
+        workers.emplace_back([&, t] {
+            parsecolumn(cuts[t], cuts[t + 1], column, parts[t]);
+        });
+    parsecolumn(cuts[0], cuts[1], column, parts[0]);
+    for (std::thread & w : workers)
+        w.join();
+    for (size_t t = 1; t < chunks; ++t)
+        parts[0].insert(parts[0].end(), parts[t].begin(), parts[t].end());
+    return std::move(parts[0]);
+}
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * Streaming maximum-minimum filter over a time horizon, for irregularly
+ * sampled streams.
+ *
+ * Each sample comes with a timestamp; timestamps must not decrease. After
+ * update(time, value) the window holds the samples whose timestamp t
+ * satisfies t + horizon > time, that is, the last 'horizon' time units.
+ * The queues are the same monotonic wedges as lemiremaxmintruestreaming,
+ * keyed by timestamp instead of by sample count. As timestamps increase
+ * along each queue, the expired head entries form a prefix: it is found by
+ * a galloping search and dropped at once (cost logarithmic in the number
+ * of dropped entries, so the amortized update cost stays constant).
+ *
+ * The queues start small and double as needed, up to 'capacity' entries
+ * each. A full queue drops its oldest entry: the reported extremum is then
+ * that of the most recent part of the window only. Monotone runs longer
+ * than capacity within one horizon are the only way to hit the cap.
+ */
+
+#ifndef TIMESTREAMING_H
+#define TIMESTREAMING_H
+
+#include <algorithm>
+#include <functional>
+
+#include "common.h"
+#include "deque.h"
+
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both, typename Time = double>
+class lemiremaxmintimestreaming {
+public:
+    static const uint defaultcapacity = 1 << 20;
+
+    lemiremaxmintimestreaming(Time horizon, uint capacity = defaultcapacity,
+                              Compare c = Compare())
+        : up(), lo(), hh(horizon), cap(std::max(capacity, 1u)), comp(c) {
+        const uint initial = std::min(cap, 16u);
+        if (hasmax(Sides))
+            init(&up, initial);
+        if (hasmin(Sides))
+            init(&lo, initial);
+    }
+    lemiremaxmintimestreaming(const lemiremaxmintimestreaming &) = delete;
+    lemiremaxmintimestreaming &
+    operator=(const lemiremaxmintimestreaming &) = delete;
+
+    ~lemiremaxmintimestreaming() {
+        if (hasmax(Sides))
+            free(&up);
+        if (hasmin(Sides))
+            free(&lo);
+    }
+
+    void update(Time time, T value) {
+        if (nonempty(hasmax(Sides) ? &up : &lo) != 0) {
+            // the previous sample is the tail of both queues
+            const T previous = hasmax(Sides) ? tailvalue(&up) : tailvalue(&lo);
+            if (comp(previous, value)) {
+                if (hasmax(Sides)) {
+                    prunetail(&up);
+                    while (((nonempty(&up)) != 0) &&
+                           !comp(value, tailvalue(&up))) {
+                        prunetail(&up);
+                    }
+                }
+            } else if (hasmin(Sides)) {
+                prunetail(&lo);
+                while (((nonempty(&lo)) != 0) &&
+                       !comp(tailvalue(&lo), value)) {
+                    prunetail(&lo);
+                }
+            }
+        }
+        if (hasmax(Sides))
+            append(&up, time, value);
+        if (hasmin(Sides))
+            append(&lo, time, value);
+        expire(time);
+    }
+
+    // drops the samples that are out of the window at time now
+    void expire(Time now) {
+        if (hasmax(Sides))
+            expirehead(&up, now);
+        if (hasmin(Sides))
+            expirehead(&lo, now);
+    }
+
+    // true if no sample is in the window, max() and min() are then undefined
+    bool empty() {
+        return nonempty(hasmax(Sides) ? &up : &lo) == 0;
+    }
+    T max() {
+        return headvalue(&up);
+    }
+    T min() {
+        return headvalue(&lo);
+    }
+    // timestamp of the sample holding the current max (min)
+    Time maxtime() {
+        return headindex(&up);
+    }
+    Time mintime() {
+        return headindex(&lo);
+    }
+
+private:
+    void append(intfloatqueue<T, Time> * q, Time time, T value) {
+        const uint size = count(q);
+        if (size == cap)
+            prunehead(q);
+        else if (size == q->mask)
+            grow(q, std::min(2 * size, cap));
+        push(q, time, value);
+    }
+
+    void expirehead(intfloatqueue<T, Time> * q, Time now) {
+        const uint size = count(q);
+        if ((size == 0) || !expired(q, 0, now))
+            return;
+        // entries [0, known) are expired; gallop, then bisect [known, end)
+        uint known = 1, end = 2;
+        while ((end < size) && expired(q, end, now)) {
+            known = end + 1;
+            end *= 2;
+        }
+        end = std::min(end, size);
+        while (known < end) {
+            const uint mid = known + (end - known) / 2;
+            if (expired(q, mid, now))
+                known = mid + 1;
+            else
+                end = mid;
+        }
+        q->head = (q->head + known) & q->mask;
+    }
+
+    bool expired(intfloatqueue<T, Time> * q, uint offset, Time now) const {
+        return !(now < q->nodes[(q->head + offset) & q->mask].index + hh);
+    }
+
+    intfloatqueue<T, Time> up;
+    intfloatqueue<T, Time> lo;
+    Time hh;
+    uint cap;
+    Compare comp;
+};
+
+#endif
@@ -1,11 +1,58 @@
+#include "adaptive.h"
+#include "argmaxmin.h"
+#include "filterbank.h"
+#include "generators.h"
+#include "harness.h"
+#include "mappedio.h"
+#include "maxmin2d.h"
+#include "multilane.h"
+#include "parallel.h"
+#include "rangeindex.h"
 #include "runningmaxmin.h"
+#include "textinput.h"
+#include "timestreaming.h"
+#include "vanherksimd.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <deque>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 
-bool compare(std::vector<floattype> & a, std::vector<floattype> & b) {
+#include <cstdint>
+#include <new>
+#include <sstream>
+#include <type_traits>
+
+// counts heap allocations, to check the workspace-based filter functions
+static size_t allocations = 0;
+
+void * operator new(size_t size) {
+    ++allocations;
+    void * p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+// as used by std::stable_sort, and released through operator delete below
+void * operator new(size_t size, const std::nothrow_t &) noexcept {
+    ++allocations;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void * p) noexcept {
+    free(p);
+}
+
+void operator delete(void * p, size_t) noexcept {
+    free(p);
+}
+
+template <typename T>
+bool compare(std::vector<T> & a, std::vector<T> & b) {
     if (a.size() != b.size())
         return false;
     for (uint k = 0; k < a.size(); ++k)
@@ -13,27 +60,32 @@ bool compare(std::vector<floattype> & a, std::vector<floattype> & b) {
             return false;
     return true;
 }
-bool compare(minmaxfilter & a, minmaxfilter & b) {
+template <typename T>
+bool compare(minmaxfilter<T> & a, minmaxfilter<T> & b) {
     return static_cast<int>((compare(a.getmaxvalues(), b.getmaxvalues())) &
                             static_cast<int>(compare(a.getminvalues(),
                                                      b.getminvalues()))) != 0;
 }
 
-void display(minmaxfilter & a) {
+template <typename T>
+void display(minmaxfilter<T> & a) {
     display(a.getmaxvalues());
     display(a.getminvalues());
 }
 
-void test(std::vector<floattype> data, uint width = 3) {
+template <typename T>
+void test(std::vector<T> data, uint width = 3) {
 
-    slowmaxmin A(data, width);
-    lemiremaxmin C(data, width);
-    lemiremaxminwrap Cw(data, width);
-    simplelemiremaxmin G(data, width);
-    GilKimmel D(data, width);
-    vanHerkGilWermanmaxmin B(data, width);
-    lemirebitmapmaxmin E(data, width);
-    monowedgewrap M(data,width);
+    slowmaxmin<T> A(data, width);
+    lemiremaxmin<T> C(data, width);
+    lemiremaxminwrap<T> Cw(data, width);
+    simplelemiremaxmin<T> G(data, width);
+    GilKimmel<T> D(data, width);
+    vanHerkGilWermanmaxmin<T> B(data, width);
+    lemirebitmapmaxmin<T> E(data, width);
+    monowedgewrap<T> M(data,width);
+    vanHerkGilWermanmaxminsimd<T> V(data, width);
+    adaptivemaxmin<T> AD(data, width);
     if (!compare(A, M)) {
         std::cout << "array " << std::endl;
         display(data);
@@ -82,11 +134,1009 @@ void test(std::vector<floattype> data, uint width = 3) {
     assert(compare(A, D));
     assert(compare(A, G));
     assert(compare(A, E));
+    assert(compare(A, M));
+    assert(compare(A, V));
+    assert(compare(A, AD));
+
+    // std::deque in place of the ring buffers
+    lemiremaxmin<T, std::less<T>, minmaxsides::both, std::deque<int>> CD(data,
+                                                                         width);
+    simplelemiremaxmin<T, std::less<T>, minmaxsides::both, std::deque<int>> GD(
+        data, width);
+    monowedgewrap<T, std::less<T>, minmaxsides::both, std::deque<Sample<T>>> MD(
+        data, width);
+    assert(compare(A, CD));
+    assert(compare(A, GD));
+    assert(compare(A, MD));
+
+    // a reversed comparator swaps the roles of max and min
+    slowmaxmin<T, std::greater<T>> RA(data, width);
+    lemiremaxminwrap<T, std::greater<T>> RC(data, width);
+    vanHerkGilWermanmaxmin<T, std::greater<T>> RB(data, width);
+    vanHerkGilWermanmaxminsimd<T, std::greater<T>> RV(data, width);
+    assert(compare(RA.getmaxvalues(), A.getminvalues()));
+    assert(compare(RA.getminvalues(), A.getmaxvalues()));
+    assert(compare(RA, RC));
+    assert(compare(RA, RB));
+    assert(compare(RA, RV));
+}
+
+// the convenience wedge updates, with temporaries and named values
+void testwedgeupdates() {
+    std::deque<int> maxwedge, minwedge;
+    const int values[] = {3, 1, 4, 1, 5, 9, 2, 6};
+    for (int v : values) {
+        mono_wedge::max_wedge_update(maxwedge, v + 0); // rvalue overloads
+        mono_wedge::min_wedge_update(minwedge, v + 0);
+    }
+    assert(maxwedge == std::deque<int>({9, 6}));
+    assert(minwedge == std::deque<int>({1, 2, 6})); // the newer 1 wins
+    std::deque<std::string> words;
+    std::string word = "b";
+    mono_wedge::max_wedge_update(words, word); // lvalue, left intact
+    mono_wedge::max_wedge_update(words, std::string("a"));
+    assert(word == "b" && words == std::deque<std::string>({"b", "a"}));
+}
+
+// ringqueue against std::deque, across many wraparounds of a small ring
+void testringqueue() {
+    ringqueue<int> ring(5);
+    assert(ring.capacity() == 8);
+    assert(reinterpret_cast<uintptr_t>(&*ring.begin()) % 64 == 0);
+    std::deque<int> reference;
+    for (int k = 0; k < 1000; ++k) {
+        if ((k % 3 == 2) && !reference.empty()) {
+            ring.pop_front();
+            reference.pop_front();
+        }
+        if ((k % 7 == 6) && !reference.empty()) {
+            ring.pop_back();
+            reference.pop_back();
+        }
+        if (reference.size() == ring.capacity()) {
+            ring.pop_front();
+            reference.pop_front();
+        }
+        ring.push_back(k);
+        reference.push_back(k);
+        assert(ring.size() == reference.size());
+        assert(ring.front() == reference.front());
+        assert(ring.back() == reference.back());
+        assert(std::equal(ring.begin(), ring.end(), reference.begin()));
+        // mono_wedge drops a sorted suffix found by binary search
+        const int cut = k - 2;
+        auto it = std::lower_bound(ring.begin(), ring.end(), cut);
+        assert(it - ring.begin() ==
+               std::lower_bound(reference.begin(), reference.end(), cut) -
+                   reference.begin());
+        if (k % 5 == 4) {
+            reference.resize(it - ring.begin());
+            ring.erase(it, ring.end());
+            assert(ring.size() == reference.size());
+        }
+    }
+    ring.clear();
+    assert(ring.empty());
+}
+
+// column selection, delimiters, skipped lines and exact values
+void testtextinput() {
+    const std::string csv = "time,value; note\r\n"
+                            "1, 0.1 ;a\r\n"
+                            "\n"
+                            "2,-3e2,b\n"
+                            "3\t+7\tc\n"
+                            "4 5.5 d\n"
+                            "5,x,e\n"
+                            "6,,f\n"
+                            "7,1e-310";
+    std::vector<double> values;
+    parsecolumn(csv.data(), csv.data() + csv.size(), 1, values);
+    const std::vector<double> expected = {0.1, -300, 7, 5.5, 1e-310};
+    assert(values == expected);
+    values.clear();
+    parsecolumn(csv.data(), csv.data() + csv.size(), 0, values);
+    assert(values.size() == 7 && values[6] == 7);
+    values.clear();
+    parsecolumn(csv.data(), csv.data() + csv.size(), 3, values);
+    assert(values.empty());
+    // large enough for several threads, with lines cut anywhere
+    std::string lines;
+    std::vector<double> reference;
+    for (int k = 0; lines.size() < (size_t(3) << 20); ++k) {
+        reference.push_back(k * 0.25 - 1000);
+        lines += std::to_string(k) + "," + std::to_string(reference.back()) +
+                 "\n";
+    }
+    for (uint threads = 1; threads <= 4; ++threads)
+        assert(parsecolumn<double>(lines.data(), lines.data() + lines.size(),
+                                   1, threads) == reference);
+}
+
+// totals over filters, and the exported formats
+void testfilterstatsexport() {
+    lemiremaxmintruestreaming<double, std::less<double>, minmaxsides::both,
+                              argties::any, intfloatqueue<double>,
+                              filterstats<>>
+        filter(4);
+    for (int k = 0; k < 10; ++k)
+        filter.update(k % 3);
+    filtercounts total = filter.stats.snapshot();
+    total += filter.stats.snapshot();
+    assert(total.updates == 20 && total.maxdepth[0] <= 4 &&
+           total.depthsum[0] == 2 * filter.stats.snapshot().depthsum[0]);
+    std::ostringstream prometheus, json;
+    writeprometheus(prometheus, total, "maxmin", "filter=\"test\"");
+    writejson(json, total);
+    const std::string text = prometheus.str();
+    assert(text.find("maxmin_updates_total{filter=\"test\"} 20\n") !=
+           std::string::npos);
+    assert(text.find("maxmin_queue_depth_bucket{filter=\"test\","
+                     "queue=\"up\",le=\"+Inf\"} 20\n") != std::string::npos);
+    assert(text.find("maxmin_update_ticks_count{filter=\"test\"} 20\n") !=
+           std::string::npos);
+    assert(json.str().find("\"updates\": 20,") != std::string::npos);
+    assert(filtercounts::bucket(0) == 0 && filtercounts::bucket(1) == 1 &&
+           filtercounts::bucket(3) == 2 && filtercounts::bucket(4) == 3 &&
+           filtercounts::bucketbound(3) == 7);
+}
+
+// statistics and reports of the benchmark harness
+void testharness() {
+    const summary s = summarize({4, 1, 3, 2}, 10);
+    assert(s.median == 25 && s.mean == 25);
+    assert(std::fabs(s.variance - 500.0 / 3) < 1e-9);
+    assert(summarize({7}).median == 7 && summarize({7}).variance == 0);
+    std::vector<double> ranks(1000);
+    for (size_t k = 0; k < ranks.size(); ++k)
+        ranks[k] = static_cast<double>(ranks.size() - k);
+    assert(quantiles(ranks, {0, 0.5, 0.99, 0.999, 1}) ==
+           std::vector<double>({1, 500, 990, 999, 1000}));
+    int runs = 0;
+    perfcounters counters;
+    const measurement m = measure("count", "none", "int", 3, 100, 5,
+                                  [&] { ++runs; }, &counters);
+    assert(runs == 6); // with the warm-up run
+    assert(m.nanoseconds.size() == 5 && m.cycles.size() == 5);
+    for (int e = 0; e < hardwareevents; ++e)
+        assert(m.hasevent(e) == counters.available(e));
+    std::ostringstream csv, json;
+    writecsv(csv, {m, m});
+    const std::string lines = csv.str();
+    assert(std::count(lines.begin(), lines.end(), '\n') == 3);
+    assert(lines.find("cycles_per_element_variance") != std::string::npos);
+    writejson(json, {m});
+    assert(json.str().find("\"algorithm\": \"count\"") != std::string::npos);
+    assert(json.str().find("\"cycles_per_element\": {\"median\": ") !=
+           std::string::npos);
+}
+
+// reproducible signals with the advertised structure
+void testgenerators() {
+    const char * const names[] = {
+        "white",  "walk",   "sine:20",     "runs:8",    "sawtooth",    "steps:5",
+        "spikes", "cauchy", "quantized:3", "wedgefill", "wedgeflush:7"};
+    for (const char * name : names) {
+        signalspec spec;
+        assert(parsesignal(name, spec));
+        xoshiro256 a(42), b(42), c(43);
+        const std::vector<floattype> x = generate(spec, 1000, a);
+        assert(x.size() == 1000 && x == generate(spec, 1000, b));
+        for (floattype v : x)
+            assert(std::isfinite(v));
+        if (spec.shape != signalshape::sine &&
+            spec.shape != signalshape::sawtooth &&
+            spec.shape != signalshape::wedgefill &&
+            spec.shape != signalshape::wedgeflush)
+            assert(x != generate(spec, 1000, c));
+    }
+    signalspec spec;
+    assert(!parsesignal("bogus", spec) && !parsesignal("runs:x", spec));
+    assert(!parsesignal("runs:0", spec));
+    xoshiro256 rng;
+    parsesignal("quantized:3", spec);
+    std::vector<floattype> x = generate(spec, 1000, rng);
+    std::sort(x.begin(), x.end());
+    assert(std::unique(x.begin(), x.end()) - x.begin() == 3);
+    // runs of mean length 8: about 1000 / 8 changes of direction
+    parsesignal("runs:8", spec);
+    x = generate(spec, 1000, rng);
+    int turns = 0;
+    for (size_t k = 2; k < x.size(); ++k)
+        turns += (x[k] > x[k - 1]) != (x[k - 1] > x[k - 2]);
+    assert(turns > 80 && turns < 170);
+    parsesignal("wedgeflush:7", spec);
+    x = generate(spec, 64, rng);
+    for (size_t k = 7; k < x.size(); k += 8)
+        for (size_t j = 0; j < k; ++j)
+            assert(x[k] > x[j]);
+}
+
+// random values, kept small for integers so that every type sees many ties
+template <typename T>
+T randomvalue() {
+    return std::is_integral<T>::value ? static_cast<T>(rand() % 100 - 50)
+                                      : static_cast<T>(rand());
+}
+
+// every lane of the multi-lane filter must agree with its own scalar filter
+template <typename T>
+void testmultilane(uint width, uint lanes, uint ticks) {
+    vanHerkmultilanestreaming<T> multi(width, lanes);
+    std::vector<lemiremaxmintruestreaming<T> *> single;
+    for (uint l = 0; l < lanes; ++l)
+        single.push_back(new lemiremaxmintruestreaming<T>(width));
+    std::vector<T> tick(lanes);
+    for (uint t = 0; t < ticks; ++t) {
+        for (uint l = 0; l < lanes; ++l) {
+            tick[l] = randomvalue<T>();
+            single[l]->update(tick[l]);
+        }
+        multi.update(tick.data());
+        for (uint l = 0; l < lanes; ++l) {
+            assert(multi.max()[l] == single[l]->max());
+            assert(multi.min()[l] == single[l]->min());
+        }
+    }
+    for (uint l = 0; l < lanes; ++l)
+        delete single[l];
+}
+
+// chunked runs must reproduce the serial output exactly
+template <typename T>
+void testparallel(std::vector<T> data, uint width) {
+    slowmaxmin<T> A(data, width);
+    for (uint threads = 1; threads <= 7; ++threads) {
+        parallelmaxmin<T, lemiremaxmin<T>> P1(data, width, threads, 1);
+        parallelmaxmin<T, vanHerkGilWermanmaxmin<T>> P2(data, width, threads,
+                                                        1);
+        parallelmaxmin<T, GilKimmel<T>> P3(data, width, threads, 1);
+        parallelmaxmin<T, vanHerkGilWermanmaxminsimd<T>> P4(data, width,
+                                                            threads, 1);
+        assert(compare(A, P1));
+        assert(compare(A, P2));
+        assert(compare(A, P3));
+        assert(compare(A, P4));
+    }
+}
+
+// once the workspace is warm, repeated calls must not allocate
+template <typename T, typename Filter>
+void testworkspace(std::vector<T> & data, uint width) {
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    filterworkspace<T> ws;
+    Filter::filter(data.data(), data.size(), width, maxvalues.data(),
+                   minvalues.data(), ws);
+    const size_t before = allocations;
+    for (uint r = 0; r < 3; ++r)
+        Filter::filter(data.data(), data.size(), width, maxvalues.data(),
+                       minvalues.data(), ws);
+    assert(allocations == before);
+    slowmaxmin<T> A(data, width);
+    assert(compare(A.maxvalues, maxvalues));
+    assert(compare(A.minvalues, minvalues));
+}
+
+template <typename T>
+void testworkspace(std::vector<T> & data, uint width) {
+    testworkspace<T, slowmaxmin<T>>(data, width);
+    testworkspace<T, GilKimmel<T>>(data, width);
+    testworkspace<T, vanHerkGilWermanmaxmin<T>>(data, width);
+    testworkspace<T, vanHerkGilWermanmaxminsimd<T>>(data, width);
+    testworkspace<T, lemiremaxminwrap<T>>(data, width);
+    testworkspace<T, lemirebitmapmaxmin<T>>(data, width);
+}
+
+// the compact queues, and a sample counter wrapping past 2^32 in mid-stream
+template <typename T>
+void testcompact(std::vector<T> & data, uint width) {
+    typedef lemiremaxmintruestreaming<T, std::less<T>, minmaxsides::both,
+                                      argties::first, compactqueue<T>>
+        compact;
+    lemiremaxmintruestreaming<T, std::less<T>, minmaxsides::both,
+                              argties::first>
+        reference(width), wrapped(width);
+    compact small(width), smallwrapped(width);
+    const uint start = 0u - static_cast<uint>(data.size() / 2);
+    wrapped.n = start;
+    smallwrapped.n = start;
+    for (size_t i = 0; i < data.size(); ++i) {
+        reference.update(data[i]);
+        wrapped.update(data[i]);
+        small.update(data[i]);
+        T maxvalue, minvalue;
+        smallwrapped.update_batch(&data[i], 1, &maxvalue, &minvalue);
+        assert(wrapped.max() == reference.max());
+        assert(wrapped.min() == reference.min());
+        assert(small.max() == reference.max());
+        assert(small.min() == reference.min());
+        assert(maxvalue == reference.max() && minvalue == reference.min());
+        assert(small.argmax() == reference.argmax());
+        assert(small.argmin() == reference.argmin());
+        assert(wrapped.argmax() - start == reference.argmax());
+        assert(smallwrapped.argmin() - start == reference.argmin());
+    }
+}
+
+// the bank against one streaming filter per width
+template <typename T, minmaxsides Sides>
+void testbank(const std::vector<T> & data, const std::vector<uint> & widths) {
+    lemiremaxminbank<T, std::less<T>, Sides> bank(widths);
+    lemiremaxminbank<T, std::less<T>, Sides> batched(widths);
+    // read now and then, so that its cursors go stale or far behind
+    lemiremaxminbank<T, std::less<T>, Sides> sparse(widths);
+    std::vector<lemiremaxmintruestreaming<T, std::less<T>, Sides> *> single;
+    for (uint width : widths)
+        single.push_back(
+            new lemiremaxmintruestreaming<T, std::less<T>, Sides>(width));
+    std::vector<T> maxvalues(widths.size()), minvalues(widths.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        bank.update(data[i]);
+        batched.update_batch(&data[i], 1, maxvalues.data(), minvalues.data());
+        sparse.update(data[i]);
+        const bool read = rand() % 37 == 0;
+        for (size_t k = 0; k < widths.size(); ++k) {
+            single[k]->update(data[i]);
+            if (read && hasmax(Sides))
+                assert(sparse.max(k) == single[k]->max() &&
+                       sparse.argmax(k) == bank.argmax(k));
+            if (read && hasmin(Sides))
+                assert(sparse.min(k) == single[k]->min() &&
+                       sparse.argmin(k) == bank.argmin(k));
+            if (hasmax(Sides)) {
+                assert(bank.max(k) == single[k]->max());
+                assert(batched.max(k) == maxvalues[k]);
+                assert(data[bank.argmax(k)] == bank.max(k));
+                assert(i - bank.argmax(k) < widths[k]);
+            }
+            if (hasmin(Sides)) {
+                assert(bank.min(k) == single[k]->min());
+                assert(batched.min(k) == minvalues[k]);
+                assert(data[bank.argmin(k)] == bank.min(k));
+                assert(i - bank.argmin(k) < widths[k]);
+            }
+        }
+    }
+    for (size_t k = 0; k < widths.size(); ++k)
+        delete single[k];
+}
+
+template <typename T>
+void testbank(const std::vector<T> & data, const std::vector<uint> & widths) {
+    testbank<T, minmaxsides::both>(data, widths);
+    testbank<T, minmaxsides::maxonly>(data, widths);
+    testbank<T, minmaxsides::minonly>(data, widths);
+}
+
+// every range of the first values, then random ranges, against a scan
+template <typename T, minmaxsides Sides>
+void testrange(const std::vector<T> & data) {
+    rangemaxmin<T, std::less<T>, Sides> index(data);
+    auto check = [&](size_t begin, size_t end) {
+        const T maxvalue = *std::max_element(&data[begin], &data[0] + end);
+        const T minvalue = *std::min_element(&data[begin], &data[0] + end);
+        if (hasmax(Sides))
+            assert(index.max(begin, end) == maxvalue);
+        if (hasmin(Sides))
+            assert(index.min(begin, end) == minvalue);
+    };
+    const size_t small = std::min<size_t>(data.size(), 150);
+    for (size_t begin = 0; begin < small; ++begin)
+        for (size_t end = begin + 1; end <= small; ++end)
+            check(begin, end);
+    std::vector<size_t> begins(500), ends(500);
+    for (size_t q = 0; q < begins.size(); ++q) {
+        begins[q] = rand() % data.size();
+        ends[q] = begins[q] + 1 + rand() % (data.size() - begins[q]);
+        check(begins[q], ends[q]);
+    }
+    std::vector<T> maxvalues(begins.size()), minvalues(begins.size());
+    index.query(begins.data(), ends.data(), begins.size(),
+                hasmax(Sides) ? maxvalues.data() : nullptr,
+                hasmin(Sides) ? minvalues.data() : nullptr);
+    for (size_t q = 0; q < begins.size(); ++q) {
+        if (hasmax(Sides))
+            assert(maxvalues[q] == index.max(begins[q], ends[q]));
+        if (hasmin(Sides))
+            assert(minvalues[q] == index.min(begins[q], ends[q]));
+    }
+}
+
+template <typename T>
+void testrange(const std::vector<T> & data) {
+    testrange<T, minmaxsides::both>(data);
+    testrange<T, minmaxsides::maxonly>(data);
+    testrange<T, minmaxsides::minonly>(data);
+}
+
+// strided output must be every stride-th window of the full output
+template <typename T>
+void teststride(std::vector<T> & data, uint width) {
+    slowmaxmin<T> A(data, width);
+    const uint strides[] = {1, 2, 3, 7, width - 1, width, width + 1,
+                            2 * width + 3};
+    for (uint stride : strides) {
+        if (stride == 0)
+            continue;
+        const size_t count = stridedsize(data.size(), width, stride);
+        assert((count - 1) * stride + width <= data.size());
+        assert(count * stride + width > data.size());
+        std::vector<T> maxvalues(count), minvalues(count), maxonly(count);
+        vanHerkGilWermanmaxmin<T>::filterstrided(
+            data.data(), data.size(), width, stride, maxvalues.data(),
+            minvalues.data());
+        vanHerkGilWermanmaxmin<T, std::less<T>, minmaxsides::maxonly>::
+            filterstrided(data.data(), data.size(), width, stride,
+                          maxonly.data(), nullptr);
+        for (size_t k = 0; k < count; ++k) {
+            assert(maxvalues[k] == A.getmaxvalues()[k * stride]);
+            assert(minvalues[k] == A.getminvalues()[k * stride]);
+            assert(maxonly[k] == maxvalues[k]);
+        }
+        lemiremaxminwrap<T>::filterstrided(data.data(), data.size(), width,
+                                           stride, maxvalues.data(),
+                                           minvalues.data());
+        for (size_t k = 0; k < count; ++k) {
+            assert(maxvalues[k] == A.getmaxvalues()[k * stride]);
+            assert(minvalues[k] == A.getminvalues()[k * stride]);
+        }
+        filterworkspace<T> ws;
+        for (int i = 0; i <= static_cast<int>(hostisa()); ++i) {
+            vanHerkGilWermanmaxminsimd<T>::filterstridedon(
+                static_cast<cpuisa>(i), data.data(), data.size(), width,
+                stride, maxvalues.data(), minvalues.data(), ws);
+            vanHerkGilWermanmaxminsimd<T, std::less<T>, minmaxsides::maxonly>::
+                filterstridedon(static_cast<cpuisa>(i), data.data(),
+                                data.size(), width, stride, maxonly.data(),
+                                nullptr, ws);
+            for (size_t k = 0; k < count; ++k) {
+                assert(maxvalues[k] == A.getmaxvalues()[k * stride]);
+                assert(minvalues[k] == A.getminvalues()[k * stride]);
+                assert(maxonly[k] == maxvalues[k]);
+            }
+        }
+        GilKimmel<T>::filterstrided(data.data(), data.size(), width, stride,
+                                    maxvalues.data(), minvalues.data());
+        GilKimmel<T, std::less<T>, minmaxsides::maxonly>::filterstrided(
+            data.data(), data.size(), width, stride, maxonly.data(), nullptr);
+        for (size_t k = 0; k < count; ++k) {
+            assert(maxvalues[k] == A.getmaxvalues()[k * stride]);
+            assert(minvalues[k] == A.getminvalues()[k * stride]);
+            assert(maxonly[k] == maxvalues[k]);
+        }
+    }
+}
+
+// through files, in chunks shorter and longer than the window
+template <typename T>
+void testmapped(const std::vector<T> & data, uint width) {
+    const char * const input = "unit_mapped_in.tmp";
+    const char * const maxname = "unit_mapped_max.tmp";
+    const char * const minname = "unit_mapped_min.tmp";
+    const size_t outputs = data.size() - width + 1;
+    {
+        mappedfile in(input, data.size() * sizeof(T));
+        std::copy(data.begin(), data.end(), in.values<T>());
+    }
+    std::vector<T> maxvalues(outputs), minvalues(outputs);
+    lemiremaxmin<T>::filter(data.data(), data.size(), width, maxvalues.data(),
+                            minvalues.data());
+    for (size_t chunk : {size_t(1), size_t(7), size_t(1) << 20}) {
+        mappedfile in(input);
+        assert(in.size() == data.size() * sizeof(T));
+        mappedfile maxout(maxname, outputs * sizeof(T));
+        mappedfile minout(minname, outputs * sizeof(T));
+        filtermapped<lemiremaxmin<T>, T>(in, &maxout, &minout, width, chunk);
+        assert(std::equal(maxvalues.begin(), maxvalues.end(),
+                          maxout.values<T>()));
+        assert(std::equal(minvalues.begin(), minvalues.end(),
+                          minout.values<T>()));
+    }
+    std::remove(input);
+    std::remove(maxname);
+    std::remove(minname);
+}
+
+// feeding a stream in blocks of random sizes must match per-sample updates
+template <typename T>
+void testbatch(std::vector<T> & data, uint width) {
+    lemiremaxmintruestreaming<T> single(width);
+    lemiremaxmintruestreaming<T> batched(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(rand() % 40, data.size() - i);
+        batched.update_batch(&data[i], count, &maxvalues[i], &minvalues[i]);
+        i += count;
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+        single.update(data[i]);
+        assert(single.max() == maxvalues[i]);
+        assert(single.min() == minvalues[i]);
+    }
+}
+
+// the branchless streaming filter must give the outputs of the branchy one,
+// positions included, per sample and in batches
+template <typename T, minmaxsides Sides>
+void testbranchless(const std::vector<T> & data, uint width) {
+    lemiremaxmintruestreaming<T, std::less<T>, Sides> branchy(width);
+    lemiremaxminbranchless<T, std::less<T>, Sides> single(width);
+    lemiremaxminbranchless<T, std::less<T>, Sides> batched(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(rand() % 40, data.size() - i);
+        batched.update_batch(&data[i], count, &maxvalues[i], &minvalues[i]);
+        i += count;
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+        branchy.update(data[i]);
+        single.update(data[i]);
+        if (hasmax(Sides))
+            assert(single.max() == branchy.max() &&
+                   single.argmax() == branchy.argmax() &&
+                   maxvalues[i] == branchy.max());
+        if (hasmin(Sides))
+            assert(single.min() == branchy.min() &&
+                   single.argmin() == branchy.argmin() &&
+                   minvalues[i] == branchy.min());
+    }
+}
+
+template <typename T>
+void testbranchless(const std::vector<T> & data, uint width) {
+    testbranchless<T, minmaxsides::both>(data, width);
+    testbranchless<T, minmaxsides::maxonly>(data, width);
+    testbranchless<T, minmaxsides::minonly>(data, width);
+}
+
+// the bounded streaming filter must give the outputs of the branchy one
+// that resolves ties to the newest sample, per sample and in batches
+template <typename T, minmaxsides Sides>
+void testbounded(const std::vector<T> & data, uint width) {
+    lemiremaxmintruestreaming<T, std::less<T>, Sides, argties::last> branchy(
+        width);
+    lemiremaxminbounded<T, std::less<T>, Sides> single(width);
+    lemiremaxminbounded<T, std::less<T>, Sides> batched(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    for (size_t i = 0; i < data.size();) {
+        const size_t count = std::min<size_t>(rand() % 40, data.size() - i);
+        batched.update_batch(&data[i], count, &maxvalues[i], &minvalues[i]);
+        i += count;
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+        branchy.update(data[i]);
+        single.update(data[i]);
+        if (hasmax(Sides))
+            assert(single.max() == branchy.max() &&
+                   single.argmax() == branchy.argmax() &&
+                   maxvalues[i] == branchy.max());
+        if (hasmin(Sides))
+            assert(single.min() == branchy.min() &&
+                   single.argmin() == branchy.argmin() &&
+                   minvalues[i] == branchy.min());
+    }
+}
+
+template <typename T>
+void testbounded(const std::vector<T> & data, uint width) {
+    testbounded<T, minmaxsides::both>(data, width);
+    testbounded<T, minmaxsides::maxonly>(data, width);
+    testbounded<T, minmaxsides::minonly>(data, width);
+}
+
+// a one-sided filter must match that side of the naive filter, given a
+// null pointer for the other side
+template <typename T, template <typename, typename, minmaxsides, typename...> class Filter>
+void testsides(std::vector<T> & data, uint width) {
+    typedef Filter<T, std::less<T>, minmaxsides::maxonly> MaxFilter;
+    typedef Filter<T, std::less<T>, minmaxsides::minonly> MinFilter;
+    slowmaxmin<T> A(data, width);
+    std::vector<T> values(data.size() - width + 1);
+    MaxFilter::filter(data.data(), data.size(), width, values.data(), nullptr);
+    assert(compare(A.maxvalues, values));
+    MinFilter::filter(data.data(), data.size(), width, nullptr, values.data());
+    assert(compare(A.minvalues, values));
+    parallelfilter<MaxFilter>(data.data(), data.size(), width, values.data(),
+                              (T *)nullptr, 3, 1);
+    assert(compare(A.maxvalues, values));
+    MaxFilter M(data, width);
+    MinFilter N(data, width);
+    assert(compare(A.maxvalues, M.maxvalues) && M.minvalues.empty());
+    assert(compare(A.minvalues, N.minvalues) && N.maxvalues.empty());
+}
+
+template <typename T>
+void testsides(std::vector<T> & data, uint width) {
+    testsides<T, slowmaxmin>(data, width);
+    testsides<T, GilKimmel>(data, width);
+    testsides<T, vanHerkGilWermanmaxmin>(data, width);
+    testsides<T, vanHerkGilWermanmaxminsimd>(data, width);
+    testsides<T, lemiremaxmin>(data, width);
+    testsides<T, lemiremaxminwrap>(data, width);
+    testsides<T, monowedgewrap>(data, width);
+    testsides<T, simplelemiremaxmin>(data, width);
+    testsides<T, lemirebitmapmaxmin>(data, width);
+    testsides<T, adaptivemaxmin>(data, width);
+    // streaming, per sample and in batches
+    typedef lemiremaxmintruestreaming<T, std::less<T>, minmaxsides::maxonly>
+        upstream;
+    typedef lemiremaxmintruestreaming<T, std::less<T>, minmaxsides::minonly>
+        lostream;
+    lemiremaxmintruestreaming<T> both(width);
+    upstream up(width), upbatch(width);
+    lostream lo(width), lobatch(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    upbatch.update_batch(data.data(), data.size(), maxvalues.data(), nullptr);
+    lobatch.update_batch(data.data(), data.size(), nullptr, minvalues.data());
+    for (size_t i = 0; i < data.size(); ++i) {
+        both.update(data[i]);
+        up.update(data[i]);
+        lo.update(data[i]);
+        assert(up.max() == both.max() && maxvalues[i] == both.max());
+        assert(lo.min() == both.min() && minvalues[i] == both.min());
+    }
+}
+
+// every instruction set the host has must give the scalar results
+template <typename T, typename Compare>
+void testisa(std::vector<T> & data, uint width) {
+    typedef vanHerkGilWermanmaxminsimd<T, Compare> simd;
+    slowmaxmin<T, Compare> A(data, width);
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    filterworkspace<T> ws;
+    for (int i = 0; i <= static_cast<int>(hostisa()); ++i) {
+        simd::filteron(static_cast<cpuisa>(i), data.data(), data.size(), width,
+                       maxvalues.data(), minvalues.data(), ws);
+        assert(compare(A.maxvalues, maxvalues));
+        assert(compare(A.minvalues, minvalues));
+    }
+}
+
+template <typename T>
+void testisa(std::vector<T> & data, uint width) {
+    testisa<T, std::less<T>>(data, width);
+    testisa<T, std::greater<T>>(data, width);
+}
+
+// signed zeros: every instruction set must pick the zero the scalar filter
+// picks, not only an equal value
+template <typename T, typename Compare>
+void testsignedzeros(std::vector<T> & data, uint width) {
+    typedef vanHerkGilWermanmaxminsimd<T, Compare> simd;
+    vanHerkGilWermanmaxmin<T, Compare> A(data, width);
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    filterworkspace<T> ws;
+    for (int i = 0; i <= static_cast<int>(hostisa()); ++i) {
+        simd::filteron(static_cast<cpuisa>(i), data.data(), data.size(), width,
+                       maxvalues.data(), minvalues.data(), ws);
+        for (size_t k = 0; k < maxvalues.size(); ++k) {
+            assert(std::signbit(maxvalues[k]) == std::signbit(A.maxvalues[k]));
+            assert(std::signbit(minvalues[k]) == std::signbit(A.minvalues[k]));
+        }
+    }
+}
+
+template <typename T>
+void testsignedzeros() {
+    std::vector<T> zeros(700);
+    for (size_t k = 0; k < zeros.size(); ++k)
+        zeros[k] = rand() % 16 == 0 ? T(rand() % 2 ? 1 : -1)
+                                    : (rand() % 2 ? T(0) : -T(0));
+    const uint widths[] = {1, 3, 8, 17, 64, 300};
+    for (uint width : widths) {
+        testsignedzeros<T, std::less<T>>(zeros, width);
+        testsignedzeros<T, std::greater<T>>(zeros, width);
+    }
+}
+
+// every engine, the choice on extreme inputs, and saved tables
+template <typename T>
+void testadaptive(std::vector<T> & data, uint width) {
+    typedef adaptivemaxmin<T> adaptive;
+    slowmaxmin<T> A(data, width);
+    std::vector<T> maxvalues(data.size() - width + 1);
+    std::vector<T> minvalues(data.size() - width + 1);
+    filterworkspace<T> ws;
+    for (int e = 0; e <= static_cast<int>(maxminengine::lemire); ++e) {
+        adaptive::run(static_cast<maxminengine>(e), data.data(), data.size(),
+                      width, maxvalues.data(), minvalues.data(), ws);
+        assert(compare(A.maxvalues, maxvalues));
+        assert(compare(A.minvalues, minvalues));
+    }
+    xoshiro256 rng;
+    signalspec white, fill;
+    parsesignal("white", white);
+    parsesignal("wedgefill", fill);
+    const std::vector<T> noise = convert<T>(generate(white, 1 << 15, rng));
+    const std::vector<T> ramp = convert<T>(generate(fill, 1 << 15, rng));
+    assert(meanrunlength(noise.data(), 100, std::less<T>()) == 0);
+    assert(adaptive::runclass(
+               meanrunlength(noise.data(), noise.size(), std::less<T>())) <= 1);
+    // no turn at all: as long as the sampled stretches
+    assert(meanrunlength(ramp.data(), ramp.size(), std::less<T>()) == 255);
+    assert(adaptive::widthclass(1) == 0 && adaptive::widthclass(4) == 2 &&
+           adaptive::widthclass(5) == 3 && adaptive::widthclass(1u << 30) ==
+                                               adaptive::widthclasses - 1);
+    // the bitmap filter is left to windows of one word
+    assert(adaptive::widthclass(64) < adaptive::bitmapwidthclasses &&
+           adaptive::widthclass(65) == adaptive::bitmapwidthclasses);
+    const typename adaptive::enginetable defaults = adaptive::defaults();
+    for (int w = adaptive::bitmapwidthclasses; w < adaptive::widthclasses; ++w)
+        for (int r = 0; r < adaptive::runclasses; ++r)
+            assert(defaults[w * adaptive::runclasses + r] !=
+                   maxminengine::bitmap);
+    // a saved table comes back whole; a bad file changes nothing
+    const char * path = "unit_adaptive.tmp";
+    adaptive::table().assign(adaptive::table().size(), maxminengine::lemire);
+    assert(adaptive::save(path));
+    adaptive::table() = adaptive::defaults();
+    assert(adaptive::choose(ramp.data(), ramp.size(), 3) ==
+           maxminengine::bitmap);
+    assert(adaptive::load(path));
+    assert(adaptive::choose(noise.data(), noise.size(), 3) ==
+           maxminengine::lemire);
+    std::FILE * file = std::fopen(path, "w");
+    std::fputs("adaptivemaxmin 14 10\nvanherk\n", file);
+    std::fclose(file);
+    assert(!adaptive::load(path));
+    assert(adaptive::choose(noise.data(), noise.size(), 3) ==
+           maxminengine::lemire);
+    std::remove(path);
+    adaptive::table() = adaptive::defaults();
 }
 
+// one-sided multi-lane filters must agree with the two-sided one
+template <typename T>
+void testmultilanesides(uint width, uint lanes, uint ticks) {
+    vanHerkmultilanestreaming<T> both(width, lanes);
+    vanHerkmultilanestreaming<T, std::less<T>, minmaxsides::maxonly> up(
+        width, lanes);
+    vanHerkmultilanestreaming<T, std::less<T>, minmaxsides::minonly> lo(
+        width, lanes);
+    std::vector<T> tick(lanes);
+    for (uint t = 0; t < ticks; ++t) {
+        for (uint l = 0; l < lanes; ++l)
+            tick[l] = randomvalue<T>();
+        both.update(tick.data());
+        up.update(tick.data());
+        lo.update(tick.data());
+        for (uint l = 0; l < lanes; ++l) {
+            assert(up.max(l) == both.max(l));
+            assert(lo.min(l) == both.min(l));
+        }
+    }
+}
+
+// the 2D filter must match a direct scan of every window, with strides and
+// tiles narrower than the image
+template <typename T>
+void test2d(size_t cols, size_t rows, uint wx, uint wy, size_t tilebytes) {
+    const size_t stride = cols + 3, outcols = cols - wx + 1,
+                 outrows = rows - wy + 1, outstride = outcols + 2;
+    std::vector<T> image(rows * stride);
+    for (size_t k = 0; k < image.size(); ++k)
+        image[k] = randomvalue<T>();
+    std::vector<T> maxvalues(outrows * outstride), minvalues(maxvalues.size());
+    maxmin2d<T>::filter(image.data(), cols, rows, stride, wx, wy,
+                        maxvalues.data(), minvalues.data(), outstride,
+                        std::less<T>(), tilebytes);
+    std::vector<T> maxonly(maxvalues.size());
+    typedef lemiremaxmin<T, std::less<T>, minmaxsides::maxonly> rowfilter;
+    maxmin2d<T, std::less<T>, minmaxsides::maxonly, rowfilter>::filter(
+        image.data(), cols, rows, stride, wx, wy, maxonly.data(), nullptr,
+        outstride, std::less<T>(), tilebytes);
+    for (size_t y = 0; y < outrows; ++y)
+        for (size_t x = 0; x < outcols; ++x) {
+            T maxv = image[y * stride + x], minv = maxv;
+            for (size_t v = y; v < y + wy; ++v)
+                for (size_t u = x; u < x + wx; ++u) {
+                    maxv = std::max(maxv, image[v * stride + u]);
+                    minv = std::min(minv, image[v * stride + u]);
+                }
+            assert(maxvalues[y * outstride + x] == maxv);
+            assert(minvalues[y * outstride + x] == minv);
+            assert(maxonly[y * outstride + x] == maxv);
+        }
+}
+
+// the time-based filter must match a scan of the samples within the horizon
+template <typename T>
+void testtime(uint horizon, uint ticks) {
+    lemiremaxmintimestreaming<T, std::less<T>, minmaxsides::both, uint> f(
+        horizon);
+    lemiremaxmintimestreaming<T, std::less<T>, minmaxsides::maxonly, uint> up(
+        horizon);
+    std::vector<uint> times;
+    std::vector<T> values;
+    uint now = 0;
+    for (uint t = 0; t < ticks; ++t) {
+        now += rand() % 4 == 0 ? rand() % (2 * horizon + 1) : rand() % 3;
+        times.push_back(now);
+        values.push_back(randomvalue<T>());
+        f.update(now, values.back());
+        up.update(now, values.back());
+        size_t first = times.size() - 1;
+        while ((first > 0) && (times[first - 1] + horizon > now))
+            --first;
+        assert(!f.empty());
+        assert(f.max() == *std::max_element(values.begin() + first,
+                                            values.end()));
+        assert(f.min() == *std::min_element(values.begin() + first,
+                                            values.end()));
+        assert(up.max() == f.max());
+        assert(f.maxtime() + horizon > now && f.mintime() + horizon > now);
+    }
+    f.expire(now + horizon);
+    assert(f.empty());
+}
+
+// queues grow up to the cap, then drop their oldest entry
+template <typename T>
+void testtimecapacity() {
+    lemiremaxmintimestreaming<T, std::less<T>, minmaxsides::maxonly, uint> f(
+        1000, 40);
+    for (uint t = 0; t < 100; ++t) {
+        f.update(t, static_cast<T>(100 - t)); // every sample stays in the wedge
+        assert(f.max() == static_cast<T>(100 - (t < 40 ? 0 : t - 39)));
+    }
+}
+
+// position of the first (last) max and min of data[begin, begin + width)
+template <typename T>
+void scanarg(const std::vector<T> & data, size_t begin, uint width, bool last,
+             uint & argmax, uint & argmin) {
+    argmax = argmin = static_cast<uint>(begin);
+    for (size_t i = begin + 1; i < begin + width; ++i) {
+        if (data[argmax] < data[i] || (last && !(data[i] < data[argmax])))
+            argmax = static_cast<uint>(i);
+        if (data[i] < data[argmin] || (last && !(data[argmin] < data[i])))
+            argmin = static_cast<uint>(i);
+    }
+}
+
+template <typename T, template <typename, typename, minmaxsides, typename...> class Filter>
+void testarg(const std::vector<T> & data, uint width) {
+    const size_t outputs = data.size() - width + 1;
+    std::vector<uint> firstmax(outputs), firstmin(outputs);
+    std::vector<uint> lastmax(outputs), lastmin(outputs);
+    argfilter<Filter>(data.data(), data.size(), width, firstmax.data(),
+                      firstmin.data());
+    argfilter<Filter, argties::last>(data.data(), data.size(), width,
+                                     lastmax.data(), lastmin.data());
+    for (size_t k = 0; k < outputs; ++k) {
+        uint argmax, argmin;
+        scanarg(data, k, width, false, argmax, argmin);
+        assert(firstmax[k] == argmax && firstmin[k] == argmin);
+        scanarg(data, k, width, true, argmax, argmin);
+        assert(lastmax[k] == argmax && lastmin[k] == argmin);
+    }
+}
+
+// the filters that track positions give values and positions in one call
+template <typename T, template <typename, typename, minmaxsides,
+                                typename...> class Filter>
+void testargvalues(std::vector<T> & data, uint width) {
+    const size_t outputs = data.size() - width + 1;
+    slowmaxmin<T> A(data, width);
+    std::vector<T> maxvalues(outputs), minvalues(outputs);
+    std::vector<uint> lastmax(outputs), lastmin(outputs);
+    Filter<T, std::less<T>, minmaxsides::both>::template filter<argties::last>(
+        data.data(), data.size(), width, maxvalues.data(), minvalues.data(),
+        lastmax.data(), lastmin.data());
+    for (size_t k = 0; k < outputs; ++k) {
+        uint argmax, argmin;
+        scanarg(data, k, width, true, argmax, argmin);
+        assert(lastmax[k] == argmax && lastmin[k] == argmin);
+        assert(maxvalues[k] == A.maxvalues[k] && minvalues[k] == A.minvalues[k]);
+    }
+}
+
+// streaming positions, per sample and through update_batch
+template <typename T, argties Ties, minmaxsides Sides>
+void testargstreaming(const std::vector<T> & data, uint width) {
+    lemiremaxmintruestreaming<T, std::less<T>, Sides, Ties> single(width);
+    lemiremaxmintruestreaming<T, std::less<T>, Sides, Ties> batched(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        single.update(data[i]);
+        batched.update_batch(&data[i], 1, &maxvalues[i], &minvalues[i]);
+        uint argmax, argmin;
+        const size_t begin = i + 1 < width ? 0 : i + 1 - width;
+        scanarg(data, begin, static_cast<uint>(i + 1 - begin),
+                Ties == argties::last, argmax, argmin);
+        if (hasmax(Sides))
+            assert(single.argmax() == argmax && batched.argmax() == argmax);
+        if (hasmin(Sides))
+            assert(single.argmin() == argmin && batched.argmin() == argmin);
+    }
+}
+
+// the instrumented filter gives the same outputs and counts that add up
+template <typename T, argties Ties, minmaxsides Sides, bool Timed = true>
+void testfilterstats(const std::vector<T> & data, uint width) {
+    typedef lemiremaxmintruestreaming<T, std::less<T>, Sides, Ties,
+                                      intfloatqueue<T>, filterstats<Timed>>
+        counted;
+    lemiremaxmintruestreaming<T, std::less<T>, Sides, Ties> plain(width);
+    counted single(width), batched(width);
+    std::vector<T> maxvalues(data.size()), minvalues(data.size());
+    batched.update_batch(data.data(), data.size(), maxvalues.data(),
+                         minvalues.data());
+    for (size_t i = 0; i < data.size(); ++i) {
+        plain.update(data[i]);
+        single.update(data[i]);
+        if (hasmax(Sides))
+            assert(single.max() == plain.max() &&
+                   single.argmax() == plain.argmax() &&
+                   maxvalues[i] == plain.max());
+        if (hasmin(Sides))
+            assert(single.min() == plain.min() &&
+                   single.argmin() == plain.argmin() &&
+                   minvalues[i] == plain.min());
+    }
+    const filtercounts c = single.stats.snapshot();
+    const filtercounts b = batched.stats.snapshot();
+    const uint64_t n = data.size();
+    assert(c.updates == n && b.updates == n);
+    assert(c.comparisons == b.comparisons && c.pops == b.pops &&
+           c.evictions == b.evictions);
+    // the paper's bound, and one more per sample to resolve ties
+    assert(c.comparisons <= (Ties == argties::any ? 3 : 4) * n);
+    const uint left = (hasmax(Sides) ? count(&single.up) : 0) +
+                      (hasmin(Sides) ? count(&single.lo) : 0);
+    assert(c.pops + c.evictions + left ==
+           (hasmax(Sides) + hasmin(Sides)) * n);
+    assert(c.maxdepth[0] <= width && c.maxdepth[1] <= width);
+    uint64_t depths = 0, pops = 0, comparisons = 0, ticks = 0;
+    for (int k = 0; k < filtercounts::buckets; ++k) {
+        depths += c.depth[0][k];
+        pops += c.popsperupdate[k];
+        comparisons += c.comparisonsperupdate[k];
+        ticks += c.ticksperupdate[k];
+    }
+    assert(depths == n && pops == n && comparisons == n && ticks == n);
+    assert(Timed || (c.ticks == 0 && c.ticksperupdate[0] == n));
+    single.stats.reset();
+    assert(single.stats.snapshot().updates == 0);
+}
+
+template <typename T>
+void testarg(uint width) {
+    std::vector<T> data(150);
+    for (size_t k = 0; k < data.size(); ++k)
+        data[k] = static_cast<T>(rand() % 5); // plenty of ties
+    testarg<T, slowmaxmin>(data, width);
+    testarg<T, GilKimmel>(data, width);
+    testarg<T, vanHerkGilWermanmaxmin>(data, width);
+    testarg<T, vanHerkGilWermanmaxminsimd>(data, width);
+    testarg<T, lemiremaxmin>(data, width);
+    testarg<T, lemiremaxminwrap>(data, width);
+    testarg<T, monowedgewrap>(data, width);
+    testarg<T, simplelemiremaxmin>(data, width);
+    testarg<T, lemirebitmapmaxmin>(data, width);
+    testargvalues<T, vanHerkGilWermanmaxmin>(data, width);
+    testargvalues<T, lemiremaxmin>(data, width);
+    testargstreaming<T, argties::first, minmaxsides::both>(data, width);
+    testargstreaming<T, argties::last, minmaxsides::both>(data, width);
+    testargstreaming<T, argties::first, minmaxsides::maxonly>(data, width);
+    testargstreaming<T, argties::last, minmaxsides::maxonly>(data, width);
+    testargstreaming<T, argties::first, minmaxsides::minonly>(data, width);
+    testargstreaming<T, argties::last, minmaxsides::minonly>(data, width);
+    testfilterstats<T, argties::any, minmaxsides::both>(data, width);
+    testfilterstats<T, argties::first, minmaxsides::both>(data, width);
+    testfilterstats<T, argties::last, minmaxsides::both>(data, width);
+    testfilterstats<T, argties::any, minmaxsides::maxonly>(data, width);
+    testfilterstats<T, argties::last, minmaxsides::minonly>(data, width);
+    testfilterstats<T, argties::any, minmaxsides::both, false>(data, width);
+}
+
+template <typename T>
 void unit() {
     uint size = 20;
-    std::vector<floattype> data(size);
+    std::vector<T> data(size);
     for (uint k = 0; k < size; ++k)
         data[k] = size - k;
     test(data, 6);
@@ -102,16 +1152,98 @@ void unit() {
     test(data, 5);
     for (uint j = 0; j < 1000; ++j) {
         for (uint k = 0; k < size; ++k)
-            data[k] = rand();
+            data[k] = randomvalue<T>();
         test(data, 2);
         test(data, 3);
         test(data, 4);
         test(data, 5);
     }
+    // wide windows go through the vectorized scans and their scalar tails
+    std::vector<T> wide(200);
+    for (uint j = 0; j < 20; ++j) {
+        for (uint k = 0; k < wide.size(); ++k)
+            wide[k] = randomvalue<T>();
+        for (uint width = 7; width <= 64; width += 3)
+            test(wide, width);
+        test(wide, 64);
+    }
+    // windows past 64 samples use the multi-word bitmaps
+    std::vector<T> longer(1200);
+    for (uint k = 0; k < longer.size(); ++k)
+        longer[k] = randomvalue<T>();
+    const uint widths[] = {65, 127, 128, 129, 200, 256, 257, 511, 512, 513, 900};
+    for (uint width : widths) {
+        test(longer, width);
+        testsides(longer, width);
+    }
+    testparallel(wide, 1);
+    testparallel(wide, 5);
+    testparallel(wide, 40);
+    testworkspace(wide, 3);
+    testworkspace(wide, 50);
+    std::vector<T> ties(wide.size()); // a few levels, many equal samples
+    for (uint k = 0; k < ties.size(); ++k)
+        ties[k] = static_cast<T>(rand() % 4);
+    for (uint width = 1; width <= 70; width += 23) {
+        testbatch(wide, width);
+        testbranchless(wide, width);
+        testbranchless(ties, width);
+        testbounded(wide, width);
+        testbounded(ties, width);
+        testcompact(wide, width);
+    }
+    testbranchless(longer, 300);
+    testbounded(longer, 300);
+    testcompact(longer, 300);
+    for (uint width = 1; width <= 70; width += 23)
+        testisa(wide, width);
+    testisa(longer, 300);
+    testadaptive(wide, 1);
+    testadaptive(wide, 30);
+    testadaptive(longer, 300);
+    testbank(wide, {1});
+    testbank(wide, {10, 3, 1, 60, 3, 2});
+    testbank(longer, {600, 10, 60, 1000});
+    testrange(data);
+    testrange(wide);
+    testrange(longer);
+    for (uint width = 1; width <= 70; width += 23)
+        teststride(wide, width);
+    teststride(longer, 300);
+    testmapped(wide, 1);
+    testmapped(wide, 50);
+    for (uint width = 1; width <= 9; ++width)
+        testmultilane<T>(width, 13, 100);
+    testmultilane<T>(33, 40, 500);
+    for (uint width = 1; width <= 70; width += 23)
+        testsides(wide, width);
+    testmultilanesides<T>(7, 9, 100);
+    test2d<T>(1, 1, 1, 1, 1 << 18);
+    test2d<T>(37, 23, 5, 4, 1 << 18);
+    test2d<T>(300, 17, 9, 17, 1 << 10); // several tiles, one output row
+    test2d<T>(150, 40, 1, 6, 1 << 10);
+    testtime<T>(1, 200);
+    testtime<T>(10, 2000);
+    testtimecapacity<T>();
+    for (uint width = 1; width <= 64; width += 9)
+        testarg<T>(width);
 }
 
 int main() {
-  unit();
+  unit<float>();
+  unit<double>();
+  unit<int8_t>();
+  unit<int16_t>();
+  unit<int32_t>();
+  unit<int64_t>();
+  testsignedzeros<float>();
+  testsignedzeros<double>();
+  testringqueue();
+  testwedgeupdates();
+  testtextinput();
+  testharness();
+  testfilterstatsexport();
+  testgenerators();
   std::cout << "Code appears ok." << std::endl;
   return 0;
 }
@@ -0,0 +1,353 @@
+/**
+ * Vectorized van Herk/Gil-Werman filter for wide windows.
+ *
+ * The scalar vanHerkGilWermanmaxmin walks its R (suffix) block backward and
+ * merges it in reverse order, which the compiler cannot vectorize. Here the
+ * suffix block is stored forward so that the merge is a plain element-wise
+ * max, and both scans are done one register at a time: a log2(lanes) ladder
+ * of lane permutes computes the scan within the register, then the running
+ * value carried over from the previous register is folded in.
+ *
+ * AVX2 and AVX-512 paths are both compiled (see cpuisa.h), and each call
+ * takes the widest one the host supports. Element types or comparators
+ * without a vector path, and hosts without AVX2, fall back to
+ * vanHerkGilWermanmaxmin.
+ */
+
+#ifndef VANHERKSIMD_H
+#define VANHERKSIMD_H
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "cpuisa.h"
+#include "runningmaxmin.h"
+
+#if defined(MAXMIN_AVX2) || defined(MAXMIN_AVX512)
+#include <immintrin.h>
+#endif
+
+/**
+ * simdvec<T, ISA> wraps the vector registers of ISA for T, and
+ * simdregister<ISA> their width and lane permute indexes. Lane permutes work
+ * on 32-bit words so that a single index table serves every element size.
+ */
+template <typename T, cpuisa ISA>
+struct simdvec {
+    static const bool supported = false;
+};
+template <cpuisa ISA>
+struct simdregister;
+template <typename T, bool domax, cpuisa ISA>
+class simdscan;
+template <cpuisa ISA>
+struct simdblocks;
+
+// +1 if Compare is std::less<T>, -1 if it is std::greater<T>, 0 otherwise
+template <typename T, typename Compare>
+struct simdorder : std::integral_constant<int, 0> {};
+template <typename T>
+struct simdorder<T, std::less<T>> : std::integral_constant<int, 1> {};
+template <typename T>
+struct simdorder<T, std::greater<T>> : std::integral_constant<int, -1> {};
+
+#if defined(MAXMIN_AVX512)
+#if defined(MAXMIN_TARGET_PRAGMAS)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+template <>
+struct simdregister<cpuisa::avx512> {
+    typedef __m512i index;
+    static const int bytes = 64;
+    static index loadindex(const int * idx) {
+        return _mm512_loadu_si512(idx);
+    }
+};
+
+// The zero-masked forms under a full mask are the same instructions as the
+// plain ones, which GCC 12 warns about (-Wmaybe-uninitialized) when inlined.
+template <>
+struct simdvec<float, cpuisa::avx512> {
+    static const bool supported = true;
+    typedef __m512 reg;
+    static reg load(const float * p) { return _mm512_loadu_ps(p); }
+    static void store(float * p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg max(reg a, reg b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+    static reg min(reg a, reg b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+    static reg permute(reg v, __m512i idx) {
+        return _mm512_maskz_permutexvar_ps(0xFFFF, idx, v);
+    }
+};
+
+template <>
+struct simdvec<double, cpuisa::avx512> {
+    static const bool supported = true;
+    typedef __m512d reg;
+    static reg load(const double * p) { return _mm512_loadu_pd(p); }
+    static void store(double * p, reg v) { _mm512_storeu_pd(p, v); }
+    static reg max(reg a, reg b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+    static reg min(reg a, reg b) { return _mm512_maskz_min_pd(0xFF, a, b); }
+    static reg permute(reg v, __m512i idx) {
+        return _mm512_castps_pd(
+            _mm512_maskz_permutexvar_ps(0xFFFF, idx, _mm512_castpd_ps(v)));
+    }
+};
+
+template <>
+struct simdvec<int32_t, cpuisa::avx512> {
+    static const bool supported = true;
+    typedef __m512i reg;
+    static reg load(const int32_t * p) { return _mm512_loadu_si512(p); }
+    static void store(int32_t * p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg max(reg a, reg b) {
+        return _mm512_maskz_max_epi32(0xFFFF, a, b);
+    }
+    static reg min(reg a, reg b) {
+        return _mm512_maskz_min_epi32(0xFFFF, a, b);
+    }
+    static reg permute(reg v, __m512i idx) {
+        return _mm512_maskz_permutexvar_epi32(0xFFFF, idx, v);
+    }
+};
+
+template <>
+struct simdvec<int64_t, cpuisa::avx512> {
+    static const bool supported = true;
+    typedef __m512i reg;
+    static reg load(const int64_t * p) { return _mm512_loadu_si512(p); }
+    static void store(int64_t * p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg max(reg a, reg b) { return _mm512_maskz_max_epi64(0xFF, a, b); }
+    static reg min(reg a, reg b) { return _mm512_maskz_min_epi64(0xFF, a, b); }
+    static reg permute(reg v, __m512i idx) {
+        return _mm512_maskz_permutexvar_epi32(0xFFFF, idx, v);
+    }
+};
+
+#define VANHERKSIMD_ISA cpuisa::avx512
+#include "vanherksimdscan.h"
+#undef VANHERKSIMD_ISA
+
+#if defined(MAXMIN_TARGET_PRAGMAS)
+#pragma GCC pop_options
+#endif
+#endif
+
+#if defined(MAXMIN_AVX2)
+#if defined(MAXMIN_TARGET_PRAGMAS)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+template <>
+struct simdregister<cpuisa::avx2> {
+    typedef __m256i index;
+    static const int bytes = 32;
+    static index loadindex(const int * idx) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx));
+    }
+};
+
+template <>
+struct simdvec<float, cpuisa::avx2> {
+    static const bool supported = true;
+    typedef __m256 reg;
+    static reg load(const float * p) { return _mm256_loadu_ps(p); }
+    static void store(float * p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg permute(reg v, __m256i idx) {
+        return _mm256_permutevar8x32_ps(v, idx);
+    }
+};
+
+template <>
+struct simdvec<double, cpuisa::avx2> {
+    static const bool supported = true;
+    typedef __m256d reg;
+    static reg load(const double * p) { return _mm256_loadu_pd(p); }
+    static void store(double * p, reg v) { _mm256_storeu_pd(p, v); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static reg permute(reg v, __m256i idx) {
+        return _mm256_castps_pd(
+            _mm256_permutevar8x32_ps(_mm256_castpd_ps(v), idx));
+    }
+};
+
+template <>
+struct simdvec<int32_t, cpuisa::avx2> {
+    static const bool supported = true;
+    typedef __m256i reg;
+    static reg load(const int32_t * p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+    static void store(int32_t * p, reg v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+    }
+    static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+    static reg permute(reg v, __m256i idx) {
+        return _mm256_permutevar8x32_epi32(v, idx);
+    }
+};
+
+#define VANHERKSIMD_ISA cpuisa::avx2
+#include "vanherksimdscan.h"
+#undef VANHERKSIMD_ISA
+
+#if defined(MAXMIN_TARGET_PRAGMAS)
+#pragma GCC pop_options
+#endif
+#endif
+
+/**
+ * Vectorized van Herk/Gil-Werman filter. Same outputs as
+ * vanHerkGilWermanmaxmin, down to the sign of equal zeros, on inputs
+ * without NaN (NaN breaks the associativity the register scans rely on);
+ * the vector path is taken for float, double and int32_t (and int64_t with
+ * AVX-512) under std::less or std::greater.
+ */
+template <typename T = floattype, typename Compare = std::less<T>,
+          minmaxsides Sides = minmaxsides::both>
+class vanHerkGilWermanmaxminsimd : public minmaxfilter<T> {
+public:
+    // whether some instruction set has a vector path for T and Compare
+    static const bool vectorized =
+        simdorder<T, Compare>::value != 0 &&
+        (simdvec<T, cpuisa::avx2>::supported ||
+         simdvec<T, cpuisa::avx512>::supported);
+
+    // whether the path taken on isa is vectorized
+    static bool vectorizedon(cpuisa isa) {
+        return simdorder<T, Compare>::value != 0 &&
+               ((isa >= cpuisa::avx2 && simdvec<T, cpuisa::avx2>::supported) ||
+                (isa == cpuisa::avx512 &&
+                 simdvec<T, cpuisa::avx512>::supported));
+    }
+
+    vanHerkGilWermanmaxminsimd(std::vector<T> & array, int width,
+                               Compare comp = Compare())
+        : maxvalues(hasmax(Sides) ? array.size() - width + 1 : 0),
+          minvalues(hasmin(Sides) ? array.size() - width + 1 : 0) {
+        filter(array.data(), array.size(), width, maxvalues.data(),
+               minvalues.data(), comp);
+    }
+    // filters array[0, n) into maxvalues and minvalues[0, n - width + 1)
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filter(array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    static void filter(const T * array, size_t n, int width, T * maxvalues,
+                       T * minvalues, filterworkspace<T> & ws,
+                       Compare comp = Compare()) {
+        filteron(hostisa(), array, n, width, maxvalues, minvalues, ws, comp);
+    }
+    // filter through the path of isa, which the host must support
+    static void filteron(cpuisa isa, const T * array, size_t n, int width,
+                         T * maxvalues, T * minvalues, filterworkspace<T> & ws,
+                         Compare comp = Compare()) {
+        if (isa == cpuisa::avx512 &&
+            vectorize<cpuisa::avx512>(array, n, width, maxvalues, minvalues,
+                                      ws, hasvector<cpuisa::avx512>()))
+            return;
+        if (isa >= cpuisa::avx2 &&
+            vectorize<cpuisa::avx2>(array, n, width, maxvalues, minvalues, ws,
+                                    hasvector<cpuisa::avx2>()))
+            return;
+        vanHerkGilWermanmaxmin<T, Compare, Sides>::filter(
+            array, n, width, maxvalues, minvalues, ws, comp);
+    }
+
+    /**
+     * Strided version of filter, as vanHerkGilWermanmaxmin::filterstrided:
+     * the windows starting at multiples of stride, into maxvalues and
+     * minvalues[0, stridedsize(n, width, stride)). The vector scans stop at
+     * the first and the last reported window of each block.
+     */
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              Compare comp = Compare()) {
+        filterworkspace<T> ws;
+        filterstrided(array, n, width, stride, maxvalues, minvalues, ws, comp);
+    }
+    static void filterstrided(const T * array, size_t n, uint width,
+                              uint stride, T * maxvalues, T * minvalues,
+                              filterworkspace<T> & ws,
+                              Compare comp = Compare()) {
+        filterstridedon(hostisa(), array, n, width, stride, maxvalues,
+                        minvalues, ws, comp);
+    }
+    // filterstrided through the path of isa, which the host must support
+    static void filterstridedon(cpuisa isa, const T * array, size_t n,
+                                uint width, uint stride, T * maxvalues,
+                                T * minvalues, filterworkspace<T> & ws,
+                                Compare comp = Compare()) {
+        if (stride < width) {
+            if (isa == cpuisa::avx512 &&
+                vectorizestrided<cpuisa::avx512>(
+                    array, n, width, stride, maxvalues, minvalues, ws,
+                    hasvector<cpuisa::avx512>()))
+                return;
+            if (isa >= cpuisa::avx2 &&
+                vectorizestrided<cpuisa::avx2>(array, n, width, stride,
+                                               maxvalues, minvalues, ws,
+                                               hasvector<cpuisa::avx2>()))
+                return;
+        }
+        vanHerkGilWermanmaxmin<T, Compare, Sides>::filterstrided(
+            array, n, width, stride, maxvalues, minvalues, ws, comp);
+    }
+    std::vector<T> & getmaxvalues() {
+        return maxvalues;
+    }
+    std::vector<T> & getminvalues() {
+        return minvalues;
+    }
+    std::vector<T> maxvalues;
+    std::vector<T> minvalues;
+
+private:
+    template <cpuisa ISA>
+    using hasvector =
+        std::integral_constant<bool, simdorder<T, Compare>::value != 0 &&
+                                         simdvec<T, ISA>::supported>;
+
+    template <cpuisa ISA>
+    static bool vectorize(const T *, size_t, int, T *, T *,
+                          filterworkspace<T> &, std::false_type) {
+        return false;
+    }
+    template <cpuisa ISA>
+    static bool vectorize(const T * array, size_t n, int width, T * maxvalues,
+                          T * minvalues, filterworkspace<T> & ws,
+                          std::true_type) {
+        simdblocks<ISA>::template filter<T, Sides,
+                                         (simdorder<T, Compare>::value > 0)>(
+            array, n, width, maxvalues, minvalues, ws.values(0, width),
+            ws.values(1, width));
+        return true;
+    }
+
+    template <cpuisa ISA>
+    static bool vectorizestrided(const T *, size_t, uint, uint, T *, T *,
+                                 filterworkspace<T> &, std::false_type) {
+        return false;
+    }
+    template <cpuisa ISA>
+    static bool vectorizestrided(const T * array, size_t n, uint width,
+                                 uint stride, T * maxvalues, T * minvalues,
+                                 filterworkspace<T> & ws, std::true_type) {
+        simdblocks<ISA>::template filterstrided<
+            T, Sides, (simdorder<T, Compare>::value > 0)>(
+            array, n, width, stride, maxvalues, minvalues,
+            ws.values(0, width), ws.values(1, width));
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * The instruction-set independent part of the vectorized van Herk/Gil-Werman
+ * filter: register scans and the block loop. vanherksimd.h includes it once
+ * per instruction set, with VANHERKSIMD_ISA set to it and its target enabled.
+ */
+
+// no include guard: included once per instruction set
+
+/**
+ * Running max (domax) or min scans over one register at a time.
+ */
+template <typename T, bool domax>
+class simdscan<T, domax, VANHERKSIMD_ISA> {
+public:
+    typedef simdvec<T, VANHERKSIMD_ISA> V;
+    typedef simdregister<VANHERKSIMD_ISA> R;
+    typedef typename V::reg reg;
+    typedef typename R::index simdindex;
+    static const int lanes = R::bytes / static_cast<int>(sizeof(T));
+
+    simdscan() : up(), down(), steps(0) {
+        for (int shift = 1; shift < lanes; shift <<= 1) {
+            up[steps] = laneindex(shift, -1);
+            down[steps] = laneindex(-shift, -1);
+            ++steps;
+        }
+        first = laneindex(0, 0);
+        last = laneindex(0, lanes - 1);
+    }
+
+    // std::max(a, b) or std::min(a, b): a unless b is strictly better. The
+    // vector instructions return their second operand on ties, hence the swap.
+    static reg pick(reg a, reg b) {
+        return domax ? V::max(b, a) : V::min(b, a);
+    }
+    static T pick(T a, T b) {
+        return domax ? (a < b ? b : a) : (b < a ? b : a);
+    }
+
+    // dst[i] = op(src[0], ..., src[i]); among equal values, the first one
+    void prefix(const T * src, size_t len, T * dst) const {
+        size_t i = 0;
+        if (len >= static_cast<size_t>(lanes)) {
+            reg carry = V::permute(V::load(src), first);
+            for (; i + lanes <= len; i += lanes) {
+                reg v = V::load(src + i);
+                for (int s = 0; s < steps; ++s)
+                    v = pick(V::permute(v, up[s]), v);
+                v = pick(carry, v);
+                V::store(dst + i, v);
+                carry = V::permute(v, last);
+            }
+        } else {
+            dst[0] = src[0];
+            i = 1;
+        }
+        for (; i < len; ++i)
+            dst[i] = pick(dst[i - 1], src[i]);
+    }
+
+    // dst[i] = op(src[i], ..., src[len - 1]); among equal values, the last one
+    void suffix(const T * src, size_t len, T * dst) const {
+        size_t i = len;
+        if (len >= static_cast<size_t>(lanes)) {
+            reg carry = V::permute(V::load(src + len - lanes), last);
+            for (; i >= static_cast<size_t>(lanes); i -= lanes) {
+                reg v = V::load(src + i - lanes);
+                for (int s = 0; s < steps; ++s)
+                    v = pick(V::permute(v, down[s]), v);
+                v = pick(carry, v);
+                V::store(dst + i - lanes, v);
+                carry = V::permute(v, first);
+            }
+        } else {
+            dst[len - 1] = src[len - 1];
+            i = len - 1;
+        }
+        for (; i > 0; --i)
+            dst[i - 1] = pick(dst[i], src[i - 1]);
+    }
+
+    // out[i] = op(a[i], b[i])
+    static void merge(const T * a, const T * b, size_t len, T * out) {
+        size_t i = 0;
+        for (; i + lanes <= len; i += lanes)
+            V::store(out + i, pick(V::load(a + i), V::load(b + i)));
+        for (; i < len; ++i)
+            out[i] = pick(a[i], b[i]);
+    }
+
+private:
+    // Word index moving lane i - shift to lane i (clamped to the register),
+    // or broadcasting lane 'broadcast' when it is non-negative.
+    static simdindex laneindex(int shift, int broadcast) {
+        const int words = static_cast<int>(sizeof(T)) / 4;
+        int idx[R::bytes / 4];
+        for (int w = 0; w < R::bytes / 4; ++w) {
+            int src = broadcast >= 0 ? broadcast : w / words - shift;
+            src = std::max(0, std::min(lanes - 1, src));
+            idx[w] = src * words + w % words;
+        }
+        return R::loadindex(idx);
+    }
+
+    simdindex up[8];
+    simdindex down[8];
+    int steps;
+    simdindex first;
+    simdindex last;
+};
+
+template <>
+struct simdblocks<VANHERKSIMD_ISA> {
+    // under std::greater, the max side is a running min
+    template <typename T, minmaxsides Sides, bool less>
+    static void filter(const T * a, size_t n, uint width, T * maxvalues,
+                       T * minvalues, T * R, T * S) {
+        run<T, Sides, simdscan<T, less, VANHERKSIMD_ISA>,
+            simdscan<T, !less, VANHERKSIMD_ISA>>(a, n, width, maxvalues,
+                                                  minvalues, R, S);
+    }
+
+    // every stride-th window, for stride < width
+    template <typename T, minmaxsides Sides, bool less>
+    static void filterstrided(const T * a, size_t n, uint width, uint stride,
+                              T * maxvalues, T * minvalues, T * R, T * S) {
+        if (hasmax(Sides))
+            strided(simdscan<T, less, VANHERKSIMD_ISA>(), a, n, width, stride,
+                    maxvalues, R, S);
+        if (hasmin(Sides))
+            strided(simdscan<T, !less, VANHERKSIMD_ISA>(), a, n, width,
+                    stride, minvalues, R, S);
+    }
+
+    // one side of filterstrided: the scans stop at the first and the last
+    // reported window of each block, as in vanHerkGilWermanmaxmin::strided
+    template <typename T, typename Scan>
+    static void strided(const Scan & scan, const T * a, size_t n, uint width,
+                        uint stride, T * out, T * R, T * S) {
+        for (size_t j = 0; j + width <= n; j += width) {
+            const size_t Rpos = j + width - 1;
+            const size_t m1 = std::min<size_t>(j + 2 * width - 1, n);
+            // the reported windows start at j + i, i = first, ..., last
+            const size_t first = (stride - j % stride) % stride;
+            if (first >= m1 - Rpos)
+                continue;
+            const size_t last =
+                first + (m1 - Rpos - 1 - first) / stride * stride;
+            // R[i - first] covers [j + i, Rpos], S[i] covers [Rpos, Rpos + i]
+            scan.suffix(a + j + first, width - first, R);
+            scan.prefix(a + Rpos, last + 1, S);
+            for (size_t i = first; i <= last; i += stride)
+                out[(j + i) / stride] = Scan::pick(S[i], R[i - first]);
+        }
+    }
+
+    template <typename T, minmaxsides Sides, typename MaxScan,
+              typename MinScan>
+    static void run(const T * a, size_t size, uint width, T * maxvalues,
+                    T * minvalues, T * R, T * S) {
+        const MaxScan maxscan;
+        const MinScan minscan;
+        const uint n = static_cast<uint>(size);
+        for (uint j = 0; j < n - width + 1; j += width) {
+            const uint Rpos = std::min(j + width - 1, n - 1);
+            const uint m1 = std::min(j + 2 * width - 1, n);
+            // R[i] covers [j + i, Rpos], S[i] covers [Rpos, Rpos + i]
+            if (hasmax(Sides)) {
+                maxscan.suffix(a + j, Rpos - j + 1, R);
+                maxscan.prefix(a + Rpos, m1 - Rpos, S);
+                MaxScan::merge(S, R, m1 - Rpos, maxvalues + j);
+            }
+            if (hasmin(Sides)) {
+                minscan.suffix(a + j, Rpos - j + 1, R);
+                minscan.prefix(a + Rpos, m1 - Rpos, S);
+                MinScan::merge(S, R, m1 - Rpos, minvalues + j);
+            }
+        }
+    }
+};